@@ -1,7 +1,23 @@
+#pragma once
+
 #include <iostream>
 #include <sstream>
 #include <vector>
 #include <string>
+#include <climits>
+#include <cmath>
+#include <limits>
+#include <thread>
+#include <algorithm>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define BIGINTEGER_AVX2_KERNELS
+#endif
 
 using std::vector;
 using std::max;
@@ -11,22 +27,88 @@ using std::ostream;
 using std::istream;
 using std::stringstream;
 
+class ModContext;
+class BigIntegerBatch;
+// определён в fixedint.h; преобразования с ним — в biginteger_fixedint.h
+template <size_t Bits>
+class FixedInt;
+
 class BigInteger {
 private:
     static const int base = 1e4;
+    static const int base_digits = 4;
+    static const int small_pow10[base_digits];
+    static const size_t max_small_size = 5; // base^5 > 2^63
+    static const size_t karatsuba_threshold = 48;
+    static const size_t parallel_threshold = 2048;
+    static std::atomic<unsigned> thread_count;
+    // вспомогательные потоки умножения, живые сейчас во всех вызовах вместе
+    static std::atomic<unsigned> busy_workers;
     vector<int> bits;
     bool is_positive = true;
+    // пока число помещается в long long, оно хранится в value, а bits пуст
+    bool is_small = true;
+    long long value = 0;
     void swap(BigInteger&);
     void remove_extra_zeros();
+    void normalize();
+    void promote();
+    void assign_abs(unsigned long long, bool);
+    static size_t small_limbs(long long, int*);
+    static const BigInteger& as_limbs(const BigInteger&, BigInteger&);
+    void add_abs(const BigInteger&);
+    static int add_kernel(int*, const int*, size_t, const int*, size_t);
+    static int sub_kernel(int*, const int*, size_t, const int*, size_t);
+#ifdef BIGINTEGER_AVX2_KERNELS
+    static bool has_avx2();
+    static size_t add_blocks_avx2(int*, const int*, const int*, size_t, int&);
+    static size_t sub_blocks_avx2(int*, const int*, const int*, size_t, int&);
+#endif
+    static void add_limbs(vector<int>&, const int*, size_t, size_t);
+    static void sub_limbs(vector<int>&, const vector<int>&);
+    static bool acquire_worker();
+    template <typename Task>
+    static std::thread run_limited(Task);
+    static vector<int> multiply_limbs(const int*, size_t, const int*, size_t, unsigned);
+    static void divmod_limbs(const int*, size_t, const int*, size_t, vector<int>&, vector<int>&);
+    void divide(const BigInteger&, BigInteger*);
     void shift_right();
+    void shift_abs_left(size_t);
+    void shift_abs_right(size_t);
+    static const BigInteger& word_power(size_t);
+    static BigInteger power_of_two(size_t);
+    static vector<unsigned> to_words(const BigInteger&);
+    static BigInteger from_words(const unsigned*, size_t, bool);
+    static void to_twos_complement(vector<unsigned>&, size_t, bool);
+    template <typename Operation>
+    static BigInteger bitwise(const BigInteger&, const BigInteger&, Operation);
+    template <int divisor>
+    void divide_exact();
+    int compareAbs(const BigInteger&) const;
     bool lessAbs(const BigInteger&) const;
+    bool is_negative() const;
     int get_size() const;
+    void leading_limbs(unsigned long long&, size_t&) const;
+    friend class ModContext;
+    friend class Rational;
+    friend class BigIntegerBatch;
+    friend BigIntegerBatch add_batch(const BigIntegerBatch&, const BigIntegerBatch&);
+    friend BigIntegerBatch mul_batch(const BigIntegerBatch&, const BigIntegerBatch&);
+    friend BigIntegerBatch mod_batch(const BigIntegerBatch&, const ModContext&);
     
 public:
     BigInteger();
     BigInteger(const BigInteger&);
     BigInteger(const string&);
     BigInteger(int);
+    BigInteger(long);
+    BigInteger(long long);
+    BigInteger(unsigned);
+    BigInteger(unsigned long);
+    BigInteger(unsigned long long);
+    // преобразования с FixedInt определены в biginteger_fixedint.h
+    template <size_t Bits>
+    explicit BigInteger(const FixedInt<Bits>&);
     ~BigInteger() = default;
 
     BigInteger& operator=(BigInteger);
@@ -34,6 +116,9 @@ public:
 
     BigInteger& change_sign();
     explicit operator bool() const;
+    // по модулю 2^Bits, как приведение к int
+    template <size_t Bits>
+    explicit operator FixedInt<Bits>() const;
     friend bool operator==(const BigInteger&, const BigInteger&);
     friend bool operator<(const BigInteger&, const BigInteger&);
     bool isEven() const;
@@ -47,8 +132,24 @@ public:
     BigInteger& operator%=(const BigInteger&);
     BigInteger& operator/=(const BigInteger&);
     void div2();
+    BigInteger& mul_pow10(size_t);
+    // число потоков для умножения больших чисел; результат от него не зависит.
+    // Деление остаётся однопоточным: его шаг — умножение делителя на один разряд
+    static void setThreadCount(unsigned);
+    static unsigned getThreadCount();
     void subtraction(const BigInteger&, const BigInteger&);
 
+    // битовые операции над дополнительным кодом, как у int; >> округляет вниз
+    BigInteger& operator<<=(size_t);
+    BigInteger& operator>>=(size_t);
+    BigInteger& operator&=(const BigInteger&);
+    BigInteger& operator|=(const BigInteger&);
+    BigInteger& operator^=(const BigInteger&);
+    // по модулю числа
+    size_t popcount() const;
+    size_t bit_length() const;
+    size_t ctz() const;
+
     BigInteger operator-() const;
     //префикс
     BigInteger& operator++();
@@ -58,106 +159,168 @@ public:
     BigInteger operator--(int);
     
     BigInteger& parseString(const string&); // обращение к полям класса
+    // читает [+-]цифры прямо из буфера потока; с fraction допускает одну точку
+    bool readDecimal(std::streambuf&, size_t* fraction = nullptr);
     string toString() const;
+
+    // двоичный формат, см. BINARY FORMAT
+    void appendBinary(string&) const;
+    size_t parseBinary(const char*, size_t);
+    bool readBinary(std::streambuf&, string&);
 };
 
 
 ///////////   CONSTRUCTORS   ///////////
-BigInteger::BigInteger() {
-    bits.push_back(0);
-}
+const int BigInteger::small_pow10[BigInteger::base_digits] = {1, 10, 100, 1000};
+std::atomic<unsigned> BigInteger::thread_count{1};
+std::atomic<unsigned> BigInteger::busy_workers{0};
+
+BigInteger::BigInteger() = default;
 BigInteger::BigInteger(const BigInteger& num) {
     is_positive = num.is_positive;
+    is_small = num.is_small;
+    value = num.value;
     bits = num.bits;
 }
 BigInteger::BigInteger(const string& s) {
     parseString(s);
 }
-BigInteger::BigInteger(int value) {
-    if (value == 0) {
-        bits.push_back(0);
+BigInteger::BigInteger(int num): value(num) {}
+BigInteger::BigInteger(long num): BigInteger(static_cast<long long>(num)) {}
+BigInteger::BigInteger(long long num) {
+    assign_abs(num < 0 ? -static_cast<unsigned long long>(num) : num, num >= 0);
+}
+BigInteger::BigInteger(unsigned num): value(num) {}
+BigInteger::BigInteger(unsigned long num): BigInteger(static_cast<unsigned long long>(num)) {}
+BigInteger::BigInteger(unsigned long long num) {
+    assign_abs(num, true);
+}
+int BigInteger::get_size() const {
+    int size = bits.size();
+    return size;
+}
+void BigInteger::assign_abs(unsigned long long abs_value, bool positive) {
+    bits.clear();
+    if (abs_value <= LLONG_MAX) {
+        is_small = true;
         is_positive = true;
+        value = positive ? static_cast<long long>(abs_value) : -static_cast<long long>(abs_value);
         return;
     }
-    int num = value;
-    if (num < 0) {
-        is_positive = false;
-        num *= -1;
+    is_small = false;
+    is_positive = positive;
+    value = 0;
+    while (abs_value) {
+        bits.push_back(abs_value % base);
+        abs_value /= base;
     }
-    while (num) {
-        bits.push_back(num % base);
-        num /= base;
+}
+void BigInteger::promote() {
+    if (!is_small) return;
+    unsigned long long abs_value = value < 0 ? -static_cast<unsigned long long>(value) : value;
+    is_small = false;
+    is_positive = value >= 0;
+    value = 0;
+    bits.clear();
+    do {
+        bits.push_back(abs_value % base);
+        abs_value /= base;
+    } while (abs_value);
+}
+void BigInteger::normalize() {
+    if (is_small) return;
+    remove_extra_zeros();
+    if (bits.size() > max_small_size) return;
+    unsigned long long abs_value = 0;
+    for (int i = get_size() - 1; i >= 0; --i) {
+        if (__builtin_mul_overflow(abs_value, static_cast<unsigned long long>(base), &abs_value) ||
+            __builtin_add_overflow(abs_value, static_cast<unsigned long long>(bits[i]), &abs_value))
+            return;
     }
+    if (abs_value > LLONG_MAX) return;
+    value = is_positive ? static_cast<long long>(abs_value) : -static_cast<long long>(abs_value);
+    is_small = true;
+    is_positive = true;
+    bits.clear();
 }
-int BigInteger::get_size() const {
-    int size = bits.size();
+size_t BigInteger::small_limbs(long long num, int* limbs) {
+    unsigned long long abs_value = num < 0 ? -static_cast<unsigned long long>(num) : num;
+    size_t size = 0;
+    do {
+        limbs[size++] = abs_value % base;
+        abs_value /= base;
+    } while (abs_value);
     return size;
 }
+const BigInteger& BigInteger::as_limbs(const BigInteger& num, BigInteger& storage) {
+    if (!num.is_small) return num;
+    storage = num;
+    storage.promote();
+    return storage;
+}
 
 
 /////////////   COPYING    /////////////
 void BigInteger::swap(BigInteger& num) {
     std::swap(bits,num.bits);
     std::swap(is_positive,num.is_positive);
+    std::swap(is_small,num.is_small);
+    std::swap(value,num.value);
 }
 
 BigInteger& BigInteger::operator=(BigInteger num) {
     swap(num);
     return *this;
 }
-BigInteger& BigInteger::operator=(int value) {
+BigInteger& BigInteger::operator=(int num) {
     bits.clear();
     is_positive = true;
-    if (value == 0) {
-        bits.push_back(0);
-        return *this;
-    }
-    int num = value;
-    if (num < 0) {
-        is_positive = false;
-        num *= -1;
-    }
-    while (num) {
-        bits.push_back(num % base);
-        num /= base;
-    }
+    is_small = true;
+    value = num;
     return *this;
 }
 
 
 /////////////    CAST     /////////////
 BigInteger::operator bool() const{
-    return bits.back() != 0;
+    return is_small ? value != 0 : bits.back() != 0;
 }
 
 
 /////////////   LOGICAL    /////////////
-bool operator==(const BigInteger& num1, const BigInteger& num2) {
-    if (num1.bits.size() != num2.bits.size() || num1.is_positive != num2.is_positive) return false;
-    for (int i = 0; i < num1.get_size(); ++i) {
-        if (num1.bits[i] != num2.bits[i]){
-            return false;
-        }
+bool BigInteger::is_negative() const {
+    return is_small ? value < 0 : !is_positive && bits.back() != 0;
+}
+int BigInteger::compareAbs(const BigInteger& num) const {
+    int buf1[max_small_size], buf2[max_small_size];
+    const int* limbs1 = is_small ? buf1 : bits.data();
+    const int* limbs2 = num.is_small ? buf2 : num.bits.data();
+    size_t size1 = is_small ? small_limbs(value, buf1) : bits.size();
+    size_t size2 = num.is_small ? small_limbs(num.value, buf2) : num.bits.size();
+    if (size1 != size2)
+        return size1 < size2 ? -1 : 1;
+    for (size_t i = size1; i-- > 0;) {
+        if (limbs1[i] != limbs2[i])
+            return limbs1[i] < limbs2[i] ? -1 : 1;
     }
-    return true;
+    return 0;
+}
+bool operator==(const BigInteger& num1, const BigInteger& num2) {
+    if (num1.is_small && num2.is_small)
+        return num1.value == num2.value;
+    return num1.is_negative() == num2.is_negative() && num1.compareAbs(num2) == 0;
 }
 bool operator!=(const BigInteger& num1, const BigInteger& num2) {
     return !(num1 == num2);
 }
 bool operator<(const BigInteger& num1, const BigInteger& num2) {
-    if (!num1.is_positive && num2.is_positive)
-        return true;
-    if (num1.is_positive && !num2.is_positive)
-        return false;
-    if (num1.bits.size() < num2.bits.size())
-        return num1.is_positive;
-    if (num1.bits.size() > num2.bits.size())
-        return !num1.is_positive;
-    for (int i = num1.get_size() - 1; i >= 0; --i) {
-        if (num1.bits[i] != num2.bits[i])
-            return (num1.bits[i] < num2.bits[i]) == num1.is_positive;
-    }
-    return false;
+    if (num1.is_small && num2.is_small)
+        return num1.value < num2.value;
+    bool negative = num1.is_negative();
+    if (negative != num2.is_negative())
+        return negative;
+    int cmp = num1.compareAbs(num2);
+    return negative ? cmp > 0 : cmp < 0;
 }
 bool operator<=(const BigInteger& num1, const BigInteger& num2) {
     return (num1 < num2) || (num1 == num2);
@@ -169,25 +332,22 @@ bool operator>=(const BigInteger& num1, const BigInteger& num2) {
     return !(num1 < num2);
 }
 bool BigInteger::lessAbs(const BigInteger& num) const {
-    if (bits.size() < num.bits.size())
-        return true;
-    if (bits.size() > num.bits.size())
-        return false;
-    for (int i = get_size() - 1; i >= 0; --i)
-        if (bits[i] != num.bits[i])
-            return (bits[i] < num.bits[i]);
-    return false;
+    return compareAbs(num) < 0;
 }
 bool BigInteger::isEven() const {
-    return (bits[0] % 2 == 0);
+    return is_small ? value % 2 == 0 : bits[0] % 2 == 0;
 }
 
 
 /////////////    STREAM    /////////////
 istream& operator >> (istream& in, BigInteger& num) {
-    string s;
-    in >> s;
-    num.parseString(s);
+    istream::sentry guard(in);
+    if (!guard)
+        return in;
+    if (!num.readDecimal(*in.rdbuf()))
+        in.setstate(std::ios::failbit);
+    if (in.rdbuf()->sgetc() == EOF)
+        in.setstate(std::ios::eofbit);
     return in;
 }
 ostream& operator << (ostream& out, const BigInteger& num) {
@@ -211,44 +371,140 @@ void BigInteger::remove_extra_zeros() {
 }
 
 BigInteger& BigInteger::change_sign() {
+    if (is_small) {
+        value = -value;
+        return *this;
+    }
     if (bits.back() == 0) return *this;
     is_positive = (!is_positive);
     return *this;
 }
 void BigInteger::shift_right() {
-    if (bits.empty()) {
-        bits.push_back(0);
-        return;
-    }
+    promote();
     bits.push_back(bits[bits.size() - 1]);
     for (size_t i = bits.size() - 2; i > 0; --i)
         bits[i] = bits[i - 1];
     bits[0] = 0;
 }
 
-BigInteger& BigInteger::operator+=(const BigInteger& num) {
-    if (*this == 0) {
-        *this = num;
-        return *this;
+// r = a + b, где b не длиннее a; r может совпадать с a. Возвращает перенос
+int BigInteger::add_kernel(int* r, const int* a, size_t n, const int* b, size_t m) {
+    size_t i = 0;
+    int carry = 0;
+#ifdef BIGINTEGER_AVX2_KERNELS
+    if (has_avx2())
+        i = add_blocks_avx2(r, a, b, m, carry);
+#endif
+    for (; i < m; ++i) {
+        int cur = a[i] + b[i] + carry;
+        carry = cur >= BigInteger::base;
+        r[i] = cur - (BigInteger::base & -carry);
     }
-    if (num == 0) {
-        return *this;
+    for (; i < n && carry; ++i) {
+        int cur = a[i] + carry;
+        carry = cur >= BigInteger::base;
+        r[i] = cur - (BigInteger::base & -carry);
     }
-    if ((!is_positive && num.is_positive) || (is_positive && !num.is_positive)) {
-        change_sign();
-        *this -= num;
-        change_sign();
+    if (r != a)
+        std::copy(a + i, a + n, r + i);
+    return carry;
+}
+// r = a - b, где b не больше a; r может совпадать с a или b. Возвращает заём
+int BigInteger::sub_kernel(int* r, const int* a, size_t n, const int* b, size_t m) {
+    size_t i = 0;
+    int borrow = 0;
+#ifdef BIGINTEGER_AVX2_KERNELS
+    if (has_avx2())
+        i = sub_blocks_avx2(r, a, b, m, borrow);
+#endif
+    for (; i < m; ++i) {
+        int cur = a[i] - b[i] - borrow;
+        borrow = cur < 0;
+        r[i] = cur + (BigInteger::base & -borrow);
+    }
+    for (; i < n && borrow; ++i) {
+        int cur = a[i] - borrow;
+        borrow = cur < 0;
+        r[i] = cur + (BigInteger::base & -borrow);
+    }
+    if (r != a)
+        std::copy(a + i, a + n, r + i);
+    return borrow;
+}
+#ifdef BIGINTEGER_AVX2_KERNELS
+bool BigInteger::has_avx2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+// Блоки по 8 разрядов: сначала складываем без переносов, затем переносы внутри
+// блока находятся одним сложением масок generate/propagate:
+// переносы = ((generate << 1 | carry) + propagate) ^ propagate
+__attribute__((target("avx2")))
+size_t BigInteger::add_blocks_avx2(int* r, const int* a, const int* b, size_t m, int& carry) {
+    const __m256i base_v = _mm256_set1_epi32(BigInteger::base);
+    const __m256i max_v = _mm256_set1_epi32(BigInteger::base - 1);
+    const __m256i lanes = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    size_t i = 0;
+    for (; i + 8 <= m; i += 8) {
+        __m256i cur = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+                                       _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+        unsigned generate = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(cur, max_v)));
+        unsigned propagate = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(cur, max_v)));
+        unsigned sum = ((generate << 1) | carry) + propagate;
+        __m256i carries = _mm256_and_si256(_mm256_set1_epi32((sum ^ propagate) & 0xFF), lanes);
+        cur = _mm256_sub_epi32(cur, _mm256_cmpeq_epi32(carries, lanes));
+        cur = _mm256_sub_epi32(cur, _mm256_and_si256(_mm256_cmpgt_epi32(cur, max_v), base_v));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(r + i), cur);
+        carry = (sum >> 8) & 1;
+    }
+    return i;
+}
+__attribute__((target("avx2")))
+size_t BigInteger::sub_blocks_avx2(int* r, const int* a, const int* b, size_t m, int& borrow) {
+    const __m256i base_v = _mm256_set1_epi32(BigInteger::base);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i lanes = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    size_t i = 0;
+    for (; i + 8 <= m; i += 8) {
+        __m256i cur = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+                                       _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+        unsigned generate = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(zero, cur)));
+        unsigned propagate = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(cur, zero)));
+        unsigned sum = ((generate << 1) | borrow) + propagate;
+        __m256i borrows = _mm256_and_si256(_mm256_set1_epi32((sum ^ propagate) & 0xFF), lanes);
+        cur = _mm256_add_epi32(cur, _mm256_cmpeq_epi32(borrows, lanes));
+        cur = _mm256_add_epi32(cur, _mm256_and_si256(_mm256_cmpgt_epi32(zero, cur), base_v));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(r + i), cur);
+        borrow = (sum >> 8) & 1;
+    }
+    return i;
+}
+#endif
+void BigInteger::add_abs(const BigInteger& num) {
+    size_t size = max(bits.size(), num.bits.size());
+    bits.resize(size, 0);
+    int carry = add_kernel(bits.data(), bits.data(), size, num.bits.data(), num.bits.size());
+    if (carry)
+        bits.push_back(carry);
+}
+BigInteger& BigInteger::operator+=(const BigInteger& num) {
+    long long sum;
+    if (is_small && num.is_small && !__builtin_add_overflow(value, num.value, &sum) && sum != LLONG_MIN) {
+        value = sum;
         return *this;
     }
-    int carry = 0;
-    for (size_t i = 0; i < max(bits.size(), num.bits.size()) || carry; ++i) {
-        if (i == bits.size())
-            bits.push_back(0);
-        bits[i] += carry + (i < num.bits.size() ? num.bits[i] : 0);
-        carry = bits[i] >= BigInteger::base;
-        if (carry)
-            bits[i] -= BigInteger::base;
+    BigInteger storage;
+    const BigInteger& other = as_limbs(num, storage);
+    promote();
+    if (is_positive == other.is_positive)
+        add_abs(other);
+    else if (!lessAbs(other))
+        subtraction(*this, other);
+    else {
+        subtraction(other, *this);
+        is_positive = other.is_positive;
     }
+    normalize();
     return *this;
 }
 BigInteger operator+(const BigInteger& num1, const BigInteger& num2) {
@@ -257,43 +513,20 @@ BigInteger operator+(const BigInteger& num1, const BigInteger& num2) {
     return copy;
 }
 void BigInteger::subtraction(const BigInteger& bigger, const BigInteger& smaller) {
-    int carry = 0;
-    bits.resize(bigger.bits.size());
-    for (size_t i = 0; i < smaller.bits.size() || carry; ++i) {
-        bits[i] = bigger.bits[i] - carry - (i < smaller.bits.size() ? smaller.bits[i] : 0);
-        carry = bits[i] < 0;
-        if (carry)
-            bits[i] += BigInteger::base;
-    }
+    size_t size = bigger.bits.size(), smaller_size = smaller.bits.size();
+    bits.resize(size, 0);
+    sub_kernel(bits.data(), bigger.bits.data(), size, smaller.bits.data(), std::min(smaller_size, size));
     remove_extra_zeros();
 }
 BigInteger& BigInteger::operator-=(const BigInteger& num) {
-    if (*this == 0) {
-        *this = num;
-        change_sign();
-        return *this;
-    }
-    if (num == 0) {
-        return *this;
-    }
-    if (*this == num) {
-        bits.clear();
-        bits.push_back(0);
-        is_positive = true;
-        return *this;
-    }
-    if ((!is_positive && num.is_positive) || (is_positive && !num.is_positive)) {
-        change_sign();
-        *this += num;
-        change_sign();
-        return *this;
-    }
-    if (lessAbs(num)) {
-        subtraction(num, *this);
-        change_sign();
+    long long difference;
+    if (is_small && num.is_small && !__builtin_sub_overflow(value, num.value, &difference) && difference != LLONG_MIN) {
+        value = difference;
         return *this;
     }
-    subtraction(*this, num);
+    change_sign();
+    *this += num;
+    change_sign();
     return *this;
 }
 BigInteger operator-(const BigInteger& num1, const BigInteger& num2) {
@@ -301,23 +534,116 @@ BigInteger operator-(const BigInteger& num1, const BigInteger& num2) {
     copy -= num2;
     return copy;
 }
+void BigInteger::add_limbs(vector<int>& result, const int* num, size_t size, size_t shift) {
+    if (result.size() < shift + size)
+        result.resize(shift + size, 0);
+    int* r = result.data() + shift;
+    if (add_kernel(r, r, result.size() - shift, num, size))
+        result.push_back(1);
+}
+void BigInteger::sub_limbs(vector<int>& result, const vector<int>& num) {
+    size_t size = num.size();
+    while (size > result.size() && num[size - 1] == 0)
+        --size;
+    sub_kernel(result.data(), result.data(), result.size(), num.data(), size);
+}
+// занимает место под вспомогательный поток, если их меньше thread_count - 1
+bool BigInteger::acquire_worker() {
+    unsigned busy = busy_workers.load(std::memory_order_relaxed);
+    while (busy + 1 < thread_count.load(std::memory_order_relaxed))
+        if (busy_workers.compare_exchange_weak(busy, busy + 1, std::memory_order_relaxed))
+            return true;
+    return false;
+}
+// запускает task в новом потоке, пока не исчерпан общий лимит, иначе выполняет в текущем;
+// так вложенные и одновременные умножения вместе не создают больше thread_count - 1 потоков
+template <typename Task>
+std::thread BigInteger::run_limited(Task task) {
+    if (!acquire_worker()) {
+        task();
+        return std::thread();
+    }
+    try {
+        return std::thread([task] {
+            task();
+            busy_workers.fetch_sub(1, std::memory_order_relaxed);
+        });
+    } catch (...) {
+        busy_workers.fetch_sub(1, std::memory_order_relaxed);
+        throw;
+    }
+}
+vector<int> BigInteger::multiply_limbs(const int* a, size_t n, const int* b, size_t m, unsigned threads) {
+    while (n > 0 && a[n - 1] == 0) --n;
+    while (m > 0 && b[m - 1] == 0) --m;
+    if (n == 0 || m == 0)
+        return {};
+    vector<int> result(n + m, 0);
+    if (std::min(n, m) < karatsuba_threshold) {
+        for (size_t i = 0; i < n; ++i) {
+            int carry = 0;
+            for (size_t j = 0; j < m || carry; ++j) {
+                long long cur = result[i + j] + a[i] * (j < m ? b[j] : 0) + carry;
+                result[i + j] = static_cast<int>(cur % BigInteger::base);
+                carry = static_cast<int>(cur / BigInteger::base);
+            }
+        }
+        return result;
+    }
+    // Карацуба: a = a1 * base^k + a0, b = b1 * base^k + b0
+    size_t k = max(n, m) / 2;
+    size_t n0 = std::min(n, k), m0 = std::min(m, k);
+    vector<int> sum_a(a, a + n0), sum_b(b, b + m0);
+    add_limbs(sum_a, a + n0, n - n0, 0);
+    add_limbs(sum_b, b + m0, m - m0, 0);
+    vector<int> z0, z1, z2;
+    if (threads > 1 && n + m >= parallel_threshold) {
+        // z0 в отдельном потоке, z2 тоже, если потоков хватает; z1 в текущем
+        unsigned threads0 = max(1u, threads / 3);
+        unsigned threads2 = threads >= 3 ? threads / 3 : 0;
+        unsigned threads1 = threads - threads0 - threads2;
+        std::thread worker0 = run_limited([&] { z0 = multiply_limbs(a, n0, b, m0, threads0); });
+        std::thread worker2;
+        if (threads2)
+            worker2 = run_limited([&] { z2 = multiply_limbs(a + n0, n - n0, b + m0, m - m0, threads2); });
+        z1 = multiply_limbs(sum_a.data(), sum_a.size(), sum_b.data(), sum_b.size(), threads1);
+        if (!threads2)
+            z2 = multiply_limbs(a + n0, n - n0, b + m0, m - m0, threads1);
+        if (worker0.joinable())
+            worker0.join();
+        if (worker2.joinable())
+            worker2.join();
+    } else {
+        z0 = multiply_limbs(a, n0, b, m0, 1);
+        z2 = multiply_limbs(a + n0, n - n0, b + m0, m - m0, 1);
+        z1 = multiply_limbs(sum_a.data(), sum_a.size(), sum_b.data(), sum_b.size(), 1);
+    }
+    sub_limbs(z1, z0);
+    sub_limbs(z1, z2);
+    add_limbs(result, z0.data(), z0.size(), 0);
+    add_limbs(result, z1.data(), z1.size(), k);
+    add_limbs(result, z2.data(), z2.size(), 2 * k);
+    result.resize(n + m);
+    return result;
+}
 BigInteger& BigInteger::operator*=(const BigInteger& num) {
-    if (num == 0 || *this == 0) {
+    long long product;
+    if (is_small && num.is_small && !__builtin_mul_overflow(value, num.value, &product) && product != LLONG_MIN) {
+        value = product;
+        return *this;
+    }
+    if (!num || !*this) {
         *this = 0;
         return *this;
     }
+    BigInteger storage;
+    const BigInteger& other = as_limbs(num, storage);
+    promote();
     BigInteger result;
-    result.is_positive = is_positive == num.is_positive;
-    result.bits.resize(bits.size() + num.bits.size());
-    for (size_t i = 0; i < bits.size(); ++i) {
-        int carry = 0;
-        for (size_t j = 0; j < num.bits.size() || carry; ++j) {
-            long long cur = result.bits[i + j] + bits[i] * (j < num.bits.size() ? num.bits[j] : 0) + carry;
-            result.bits[i + j] = static_cast<int>(cur % BigInteger::base);
-            carry = static_cast<int>(cur / BigInteger::base);
-        }
-    }
-    result.remove_extra_zeros();
+    result.promote();
+    result.is_positive = is_positive == other.is_positive;
+    result.bits = multiply_limbs(bits.data(), bits.size(), other.bits.data(), other.bits.size(), getThreadCount());
+    result.normalize();
     swap(result);
     return *this;
 
@@ -327,11 +653,112 @@ BigInteger operator*(const BigInteger& num1, const BigInteger& num2) {
     copy *= num2;
     return copy;
 }
+// Кнут, алгоритм D в системе base: a = quotient * b + remainder для модулей,
+// b без ведущих нулей. Делитель и делимое домножаются на base / (старший разряд b + 1),
+// тогда цифра частного по двум старшим разрядам ошибается не больше чем на 2
+void BigInteger::divmod_limbs(const int* a, size_t n, const int* b, size_t m,
+                              vector<int>& quotient, vector<int>& remainder) {
+    if (n < m) {
+        quotient.assign(1, 0);
+        remainder.assign(a, a + n);
+        return;
+    }
+    quotient.assign(n - m + 1, 0);
+    if (m == 1) {
+        int rest = 0;
+        for (size_t i = n; i-- > 0;) {
+            int cur = rest * base + a[i];
+            quotient[i] = cur / b[0];
+            rest = cur % b[0];
+        }
+        remainder.assign(1, rest);
+        return;
+    }
+    int factor = base / (b[m - 1] + 1);
+    vector<int> u(n + 1), v(m);
+    int carry = 0;
+    for (size_t i = 0; i < n; ++i) {
+        int cur = a[i] * factor + carry;
+        u[i] = cur % base;
+        carry = cur / base;
+    }
+    u[n] = carry;
+    carry = 0;
+    for (size_t i = 0; i < m; ++i) {
+        int cur = b[i] * factor + carry;
+        v[i] = cur % base;
+        carry = cur / base;
+    }
+    for (size_t j = n - m + 1; j-- > 0;) {
+        int top = u[j + m] * base + u[j + m - 1];
+        int guess = top / v[m - 1], rest = top % v[m - 1];
+        while (guess >= base || guess * v[m - 2] > rest * base + u[j + m - 2]) {
+            --guess;
+            rest += v[m - 1];
+            if (rest >= base)
+                break;
+        }
+        // u[j..j+m] -= guess * v
+        int borrow = 0;
+        carry = 0;
+        for (size_t i = 0; i < m; ++i) {
+            int product = guess * v[i] + carry;
+            carry = product / base;
+            int cur = u[i + j] - product % base - borrow;
+            borrow = cur < 0;
+            u[i + j] = cur + borrow * base;
+        }
+        int cur = u[j + m] - carry - borrow;
+        if (cur < 0) { // цифра на единицу больше нужной: возвращаем делитель
+            --guess;
+            carry = 0;
+            for (size_t i = 0; i < m; ++i) {
+                int sum = u[i + j] + v[i] + carry;
+                carry = sum >= base;
+                u[i + j] = sum - carry * base;
+            }
+            cur += carry;
+        }
+        u[j + m] = cur;
+        quotient[j] = guess;
+    }
+    remainder.assign(m, 0);
+    int rest = 0;
+    for (size_t i = m; i-- > 0;) {
+        int cur = rest * base + u[i];
+        remainder[i] = cur / factor;
+        rest = cur % factor;
+    }
+}
+// *this становится частным (с округлением к нулю), в remainder — остаток со знаком делимого
+void BigInteger::divide(const BigInteger& num, BigInteger* remainder) {
+    BigInteger storage1, storage2;
+    const BigInteger& num1 = as_limbs(*this, storage1);
+    const BigInteger& num2 = as_limbs(num, storage2);
+    bool positive = num1.is_positive, quotient_positive = num1.is_positive == num2.is_positive;
+    vector<int> quotient, rest;
+    divmod_limbs(num1.bits.data(), num1.bits.size(), num2.bits.data(), num2.bits.size(), quotient, rest);
+    if (remainder) {
+        remainder->is_small = false;
+        remainder->value = 0;
+        remainder->is_positive = positive;
+        remainder->bits.swap(rest);
+        remainder->normalize();
+    }
+    is_small = false;
+    value = 0;
+    is_positive = quotient_positive;
+    bits.swap(quotient);
+    normalize();
+}
 BigInteger& BigInteger::operator%=(const BigInteger& num) {
-    BigInteger tmp = (*this);
-    tmp /= num;
-    tmp *= num;
-    *this -= tmp;
+    if (is_small && num.is_small) {
+        value %= num.value;
+        return *this;
+    }
+    BigInteger rest;
+    divide(num, &rest);
+    swap(rest);
     return *this;
 }
 BigInteger operator%(const BigInteger& num1, const BigInteger& num2) {
@@ -340,98 +767,356 @@ BigInteger operator%(const BigInteger& num1, const BigInteger& num2) {
     return copy;
 }
 BigInteger& BigInteger::operator/=(const BigInteger& num) {
-    if (*this == 0) {
+    if (is_small && num.is_small) {
+        value /= num.value;
         return *this;
     }
-    if (*this == num) {
-        *this = 1;
-        return *this;
+    divide(num, nullptr);
+    return *this;
+}
+BigInteger operator/(const BigInteger& num1, const BigInteger& num2) {
+    BigInteger copy = num1;
+    copy /= num2;
+    return copy;
+}
+void BigInteger::setThreadCount(unsigned count) {
+    thread_count.store(max(1u, count), std::memory_order_relaxed);
+}
+unsigned BigInteger::getThreadCount() {
+    return thread_count.load(std::memory_order_relaxed);
+}
+void BigInteger::div2() {
+    if (is_small) {
+        value /= 2;
+        return;
     }
-    if (num == 1) return *this;
-    if (num == -1) {
-        is_positive = !is_positive;
-        return *this;
+    shift_abs_right(1);
+    normalize();
+}
+BigInteger& BigInteger::mul_pow10(size_t deg) { // умножение на 10^deg
+    if (!*this) return *this;
+    promote();
+    int mult = small_pow10[deg % base_digits];
+    if (mult != 1) {
+        int carry = 0;
+        for (size_t i = 0; i < bits.size(); ++i) {
+            int cur = bits[i] * mult + carry;
+            bits[i] = cur % base;
+            carry = cur / base;
+        }
+        if (carry)
+            bits.push_back(carry);
     }
-    if (lessAbs(num) || *this == 0) {
-        bits.clear();
-        bits.push_back(0);
-        is_positive = true;
-        return *this;
+    bits.insert(bits.begin(), deg / base_digits, 0);
+    normalize();
+    return *this;
+}
+
+/////////////    BITWISE    /////////////
+// Разряды десятичные, поэтому сдвиг — это умножение или деление на 2^16 за проход:
+// сдвиг n-разрядного числа на k бит стоит O(n * k / 16), а не O(n / слово), как на двоичных словах
+void BigInteger::shift_abs_left(size_t deg) {
+    while (deg > 0) {
+        int step = static_cast<int>(std::min<size_t>(deg, 16));
+        deg -= step;
+        int carry = 0;
+        for (size_t i = 0; i < bits.size(); ++i) {
+            int cur = (bits[i] << step) + carry;
+            bits[i] = cur % base;
+            carry = cur / base;
+        }
+        while (carry) {
+            bits.push_back(carry % base);
+            carry /= base;
+        }
+    }
+}
+void BigInteger::shift_abs_right(size_t deg) {
+    if (deg >= 14 * bits.size()) { // base < 2^14
+        bits.assign(1, 0);
+        return;
+    }
+    while (deg > 0) {
+        int step = static_cast<int>(std::min<size_t>(deg, 16));
+        deg -= step;
+        int remains = 0;
+        for (size_t i = bits.size(); i-- > 0;) {
+            int cur = remains * base + bits[i];
+            bits[i] = cur >> step;
+            remains = cur & ((1 << step) - 1);
+        }
+        remove_extra_zeros();
     }
-    BigInteger result, current;
-    result.is_positive = is_positive == num.is_positive;
-    result.bits.resize(bits.size());
-    for (long long i = static_cast<long long>(bits.size()) - 1; i >= 0; --i) {
-        current.shift_right();
-        current.bits[0] = bits[i];
-        current.remove_extra_zeros();
-        int x = 0, left = 0, right = BigInteger::base;
-        while (left <= right) {
-            int mid = (left + right) / 2;
-            BigInteger t = num;
-            t.is_positive = true;
-            current.is_positive = true;
-            t *= mid;
-            if (t <= current) {
-                x = mid;
-                left = mid + 1;
+}
+// 2^(32 * 2^i). Таблица растёт лениво и общая для всех потоков: элементы строятся
+// под мьютексом и больше не меняются, поэтому готовые читаются без блокировки.
+// Память не освобождается — таблица живёт до конца программы
+const BigInteger& BigInteger::word_power(size_t index) {
+    static const size_t table_size = 64;
+    static std::atomic<const BigInteger*> table[table_size];
+    static std::mutex table_mutex;
+    const BigInteger* power = table[index].load(std::memory_order_acquire);
+    if (power)
+        return *power;
+    std::lock_guard<std::mutex> lock(table_mutex);
+    for (size_t i = 0; i <= index; ++i) {
+        if (table[i].load(std::memory_order_relaxed))
+            continue;
+        const BigInteger* previous = i ? table[i - 1].load(std::memory_order_relaxed) : nullptr;
+        BigInteger* next = previous ? new BigInteger(*previous * *previous) : new BigInteger(1ULL << 32);
+        table[i].store(next, std::memory_order_release);
+    }
+    return *table[index].load(std::memory_order_relaxed);
+}
+BigInteger BigInteger::power_of_two(size_t deg) {
+    BigInteger result = 1;
+    result.promote();
+    result.shift_abs_left(deg % 32);
+    result.normalize();
+    for (size_t i = 0, words = deg / 32; words; ++i, words >>= 1)
+        if (words & 1)
+            result *= word_power(i);
+    return result;
+}
+vector<unsigned> BigInteger::to_words(const BigInteger& num) {
+    // модуль числа в 32-битных словах, младшие вперёд
+    vector<unsigned> words;
+    if (num.is_small) {
+        unsigned long long abs_value = num.value < 0 ? -static_cast<unsigned long long>(num.value) : num.value;
+        for (; abs_value; abs_value >>= 32)
+            words.push_back(static_cast<unsigned>(abs_value));
+        return words;
+    }
+    for (size_t i = num.bits.size(); i-- > 0;) {
+        unsigned long long carry = num.bits[i];
+        for (unsigned& word : words) {
+            unsigned long long cur = static_cast<unsigned long long>(word) * base + carry;
+            word = static_cast<unsigned>(cur);
+            carry = cur >> 32;
+        }
+        if (carry)
+            words.push_back(static_cast<unsigned>(carry));
+    }
+    return words;
+}
+BigInteger BigInteger::from_words(const unsigned* words, size_t size, bool positive) {
+    // длинные числа — делением пополам: старшая половина * 2^(32 * 2^i) + младшая,
+    // умножение идёт через Карацубу, степени берутся из word_power
+    static const size_t split_threshold = 64;
+    if (size > split_threshold) {
+        size_t index = 0;
+        while ((size_t(2) << index) < size)
+            ++index;
+        size_t half = size_t(1) << index;
+        BigInteger result = from_words(words + half, size - half, positive);
+        result *= word_power(index);
+        result += from_words(words, half, positive);
+        return result;
+    }
+    BigInteger result;
+    result.is_small = false;
+    result.bits.reserve(size * 5 / 2 + 1); // 2^32 < base^2.5
+    for (size_t i = size; i-- > 0;) {
+        for (int half : {static_cast<int>(words[i] >> 16), static_cast<int>(words[i] & 0xFFFF)}) {
+            int carry = half;
+            for (int& limb : result.bits) {
+                int cur = (limb << 16) + carry;
+                limb = cur % base;
+                carry = cur / base;
             }
-            else right = mid - 1;
+            for (; carry; carry /= base)
+                result.bits.push_back(carry % base);
         }
-        result.bits[i] = x;
-        if (num > 0)
-            current -= num * x;
-        else
-            current -= (-num) * x;
     }
-    result.remove_extra_zeros();
-    swap(result);
+    if (result.bits.empty())
+        result.bits.push_back(0);
+    result.is_positive = positive;
+    result.normalize();
+    return result;
+}
+void BigInteger::to_twos_complement(vector<unsigned>& words, size_t size, bool negative) {
+    words.resize(size, 0);
+    if (!negative) return;
+    unsigned carry = 1;
+    for (unsigned& word : words) {
+        word = ~word + carry;
+        carry = carry && word == 0;
+    }
+}
+template <typename Operation>
+BigInteger BigInteger::bitwise(const BigInteger& num1, const BigInteger& num2, Operation operation) {
+    if (num1.is_small && num2.is_small)
+        return BigInteger(static_cast<long long>(operation(num1.value, num2.value)));
+    vector<unsigned> words1 = to_words(num1), words2 = to_words(num2);
+    size_t size = max(words1.size(), words2.size()) + 1;
+    to_twos_complement(words1, size, num1.is_negative());
+    to_twos_complement(words2, size, num2.is_negative());
+    for (size_t i = 0; i < size; ++i)
+        words1[i] = operation(words1[i], words2[i]);
+    bool negative = words1.back() >> 31;
+    to_twos_complement(words1, size, negative);
+    return from_words(words1.data(), words1.size(), !negative);
+}
+
+BigInteger& BigInteger::operator<<=(size_t deg) {
+    if (!*this) return *this;
+    if (is_small) {
+        unsigned long long abs_value = value < 0 ? -static_cast<unsigned long long>(value) : value;
+        if (deg < 63 && 64 - __builtin_clzll(abs_value) + deg < 63) {
+            value *= 1LL << deg;
+            return *this;
+        }
+    }
+    promote();
+    if (deg > 1024)
+        *this *= power_of_two(deg);
+    else
+        shift_abs_left(deg);
+    normalize();
     return *this;
 }
-BigInteger operator/(const BigInteger& num1, const BigInteger& num2) {
+// O(n * deg / 16) на n разрядах (см. shift_abs_right); сдвиг больше длины числа — O(1)
+BigInteger& BigInteger::operator>>=(size_t deg) {
+    if (is_small) {
+        value = deg >= 63 ? (value < 0 ? -1 : 0) : value >> deg;
+        return *this;
+    }
+    // для отрицательных: x >> k = -((|x| - 1) >> k) - 1
+    bool negative = is_negative();
+    if (negative) {
+        change_sign();
+        --*this;
+    }
+    promote();
+    shift_abs_right(deg);
+    normalize();
+    if (negative) {
+        change_sign();
+        --*this;
+    }
+    return *this;
+}
+BigInteger& BigInteger::operator&=(const BigInteger& num) {
+    return *this = bitwise(*this, num, std::bit_and<>());
+}
+BigInteger& BigInteger::operator|=(const BigInteger& num) {
+    return *this = bitwise(*this, num, std::bit_or<>());
+}
+BigInteger& BigInteger::operator^=(const BigInteger& num) {
+    return *this = bitwise(*this, num, std::bit_xor<>());
+}
+BigInteger operator<<(const BigInteger& num, size_t deg) {
+    BigInteger copy = num;
+    copy <<= deg;
+    return copy;
+}
+BigInteger operator>>(const BigInteger& num, size_t deg) {
+    BigInteger copy = num;
+    copy >>= deg;
+    return copy;
+}
+BigInteger operator&(const BigInteger& num1, const BigInteger& num2) {
     BigInteger copy = num1;
-    copy /= num2;
+    copy &= num2;
     return copy;
 }
-void BigInteger::div2() {
-    for (size_t i = 0; i < bits.size(); ++i) {
-        if (i != 0)
-            bits[i - 1] += 5000 * (bits[i] % 2);
-        bits[i] /= 2;
+BigInteger operator|(const BigInteger& num1, const BigInteger& num2) {
+    BigInteger copy = num1;
+    copy |= num2;
+    return copy;
+}
+BigInteger operator^(const BigInteger& num1, const BigInteger& num2) {
+    BigInteger copy = num1;
+    copy ^= num2;
+    return copy;
+}
+size_t BigInteger::popcount() const {
+    if (is_small)
+        return __builtin_popcountll(value < 0 ? -static_cast<unsigned long long>(value) : value);
+    size_t count = 0;
+    for (unsigned word : to_words(*this))
+        count += __builtin_popcount(word);
+    return count;
+}
+// |x| лежит в [head, head + 1) * base^shift, и log2 этих границ даёт длину за O(1).
+// Если между ними степень двойки 2^k (так бывает у самих 2^k и соседних с ними чисел),
+// длина — k или k + 1, и её решает одно сравнение с 2^k
+size_t BigInteger::bit_length() const {
+    if (is_small) {
+        unsigned long long abs_value = value < 0 ? -static_cast<unsigned long long>(value) : value;
+        return abs_value ? 64 - __builtin_clzll(abs_value) : 0;
+    }
+    unsigned long long head;
+    size_t shift;
+    leading_limbs(head, shift);
+    static const double log2_base = std::log2(static_cast<double>(base));
+    double scale = static_cast<double>(shift) * log2_base;
+    // запас на ошибку округления log2 и произведения shift * log2_base
+    double margin = 1e-12 + scale * 1e-14;
+    double low = std::floor(std::log2(static_cast<double>(head)) + scale - margin);
+    double high = std::floor(std::log2(static_cast<double>(head) + 1) + scale + margin);
+    size_t length = static_cast<size_t>(high);
+    if (low == high)
+        return length + 1;
+    return compareAbs(power_of_two(length)) >= 0 ? length + 1 : length;
+}
+size_t BigInteger::ctz() const {
+    if (is_small)
+        return value ? __builtin_ctzll(value) : 0;
+    // x mod 2^16 определяется x mod 10^16, то есть четырьмя младшими разрядами.
+    // Каждые 16 нулевых битов — проход shift_abs_right по всему числу: O(n * ctz / 16)
+    BigInteger copy = *this;
+    size_t result = 0;
+    while (true) {
+        unsigned long long low = 0;
+        for (size_t i = std::min<size_t>(copy.bits.size(), 4); i-- > 0;)
+            low = low * base + copy.bits[i];
+        if (low & 0xFFFF)
+            return result + __builtin_ctzll(low);
+        copy.shift_abs_right(16);
+        result += 16;
     }
-    if (bits[bits.size() - 1] == 0 && bits.size() > 1)
-        bits.pop_back();
 }
 
+// |x| = head * base^shift + остаток < base^shift; в head до 4 старших разрядов,
+// так что у длинного числа head >= base^3 и относительная ошибка меньше 1e-12
+void BigInteger::leading_limbs(unsigned long long& head, size_t& shift) const {
+    if (is_small) {
+        head = value < 0 ? 0ull - static_cast<unsigned long long>(value) : value;
+        shift = 0;
+        return;
+    }
+    shift = bits.size() - std::min<size_t>(bits.size(), 4);
+    head = 0;
+    for (size_t i = bits.size(); i-- > shift;)
+        head = head * base + bits[i];
+}
+
+
 /////    ADDITIONAL METHODS    /////
 BigInteger greatest_common_divisor(BigInteger num1, BigInteger num2) {
-    if (num1 == 0 || num2 == 0) return 1;
+    if (!num1 || !num2) return 1;
     if (num1 < 0) num1.change_sign();
     if (num2 < 0) num2.change_sign();
-    BigInteger delta = 1;
-    while (num1 != 0 && num2 != 0) {
-        while (num1.isEven() && num2.isEven()) {
-            delta *= 2;
-            num1.div2();
-            num2.div2();
-        }
-        while (num1.isEven())
-            num1.div2();
-        while (num2.isEven())
-            num2.div2();
-        if (num1 >= num2) num1 -= num2;
-        else num2 -= num1;
+    size_t shift1 = num1.ctz(), shift2 = num2.ctz();
+    num1 >>= shift1;
+    num2 >>= shift2;
+    while (num1 != num2) {
+        if (num1 < num2) std::swap(num1, num2);
+        num1 -= num2;
+        num1 >>= num1.ctz();
     }
-    return delta * num2;
+    return num2 <<= std::min(shift1, shift2);
 }
 BigInteger pow(BigInteger& num, int deg) {
-    if (deg == 0)
-        return 1;
-    if (deg % 2 == 0) {
-        BigInteger tmp = pow(num, deg / 2);
-        return tmp * tmp;
+    BigInteger result = 1, power = num;
+    for (; deg > 0; deg >>= 1) {
+        if (deg & 1)
+            result *= power;
+        if (deg > 1)
+            power *= power;
     }
-    return num * pow(num, deg - 1);
+    return result;
 }
 
 
@@ -458,8 +1143,7 @@ BigInteger BigInteger::operator--(int) {
 /////////////    BINARY    /////////////
 BigInteger BigInteger::operator-() const {
     BigInteger copy = *this;
-    if (copy == 0) return copy;
-    copy.is_positive = !(copy.is_positive);
+    copy.change_sign();
     return copy;
 }
 
@@ -468,42 +1152,876 @@ BigInteger BigInteger::operator-() const {
 BigInteger& BigInteger::parseString(const string& s) {
     bits.clear();
     is_positive = true;
+    is_small = false;
+    value = 0;
     int last = 0;
     if (s[0] == '-') {
         is_positive = false;
         last = 1;
     }
     int s_len = s.size();
-    for (int i = s_len - 1; i >= last; i -= 4) {
-        size_t len = (i >= 4) ? 4 : i - last + 1;
-        bits.push_back(stoi(s.substr(i - len + 1, len)));
+    bits.reserve((s_len - last) / base_digits + 1);
+    for (int i = s_len - 1; i >= last; i -= base_digits) {
+        int limb = 0;
+        for (int j = std::max(last, i - base_digits + 1); j <= i; ++j)
+            limb = limb * 10 + (s[j] - '0');
+        bits.push_back(limb);
     }
+    normalize();
     return *this;
 }
+// Доступ к окну чтения чужого streambuf: gptr/egptr/gbump защищённые,
+// но указатель на член, взятый через наследника, применим к любому streambuf.
+// Через sgetc/snextc или sgetn со sputbackc разбор выходит вдвое медленнее (см. BM_ParseStream)
+struct StreamWindow : std::streambuf {
+    static const char* begin(std::streambuf& buffer) {
+        return (buffer.*&StreamWindow::gptr)();
+    }
+    static const char* end(std::streambuf& buffer) {
+        return (buffer.*&StreamWindow::egptr)();
+    }
+    // gbump принимает int, так что окно длиннее INT_MAX пропускается по частям
+    static void skip(std::streambuf& buffer, std::ptrdiff_t count) {
+        for (; count > INT_MAX; count -= INT_MAX)
+            (buffer.*&StreamWindow::gbump)(INT_MAX);
+        (buffer.*&StreamWindow::gbump)(static_cast<int>(count));
+    }
+};
+// Обычно число целиком лежит в окне буфера: тогда длина известна сразу, и разряды
+// собираются с младших, как в parseString. Иначе цифры идут от старших, и
+// выравнивание заранее неизвестно: первые 16 цифр копятся в long long, дальше —
+// по base_digits в разряд. Неполный последний разряд дополняется нулями, а в конце
+// всё число точно делится на 10^(недостающие цифры) за один проход.
+// Знак или точка без цифр после них возвращаются в поток через sputbackc, так что
+// на "-x" поток остаётся на '-'; если streambuf не принимает символ назад, он остаётся прочитанным.
+// Если fraction не nullptr, в него пишется количество цифр после точки.
+// Возвращает false, если не прочитано ни одной цифры
+bool BigInteger::readDecimal(std::streambuf& in, size_t* fraction) {
+    static const size_t head_digits = 16;
+    bool positive = true;
+    int sign = in.sgetc(), c = sign;
+    if (c == '-' || c == '+') {
+        positive = (c == '+');
+        c = in.snextc();
+    }
+    if (c != EOF) {
+        const char* begin = StreamWindow::begin(in);
+        const char* end = StreamWindow::end(in);
+        const char* last = begin;
+        while (last != end && static_cast<unsigned>(*last - '0') <= 9)
+            ++last;
+        if (last != begin && last != end && !(*last == '.' && fraction)) {
+            size_t length = last - begin;
+            if (fraction)
+                *fraction = 0;
+            StreamWindow::skip(in, length);
+            if (length <= 18) {
+                unsigned long long abs_value = 0;
+                for (const char* digit = begin; digit != last; ++digit)
+                    abs_value = abs_value * 10 + (*digit - '0');
+                assign_abs(abs_value, positive);
+                return true;
+            }
+            is_small = false;
+            value = 0;
+            is_positive = positive;
+            bits.resize((length + base_digits - 1) / base_digits);
+            for (size_t i = 0; i < bits.size(); ++i, last -= base_digits) {
+                const char* first = last - begin > base_digits ? last - base_digits : begin;
+                int limb = 0;
+                for (const char* digit = first; digit != last; ++digit)
+                    limb = limb * 10 + (*digit - '0');
+                bits[i] = limb;
+            }
+            normalize();
+            return true;
+        }
+    }
+    bool point = false, stop = false;
+    size_t digits = 0, point_digits = 0;
+    unsigned long long head = 0;
+    int limb = 0, limb_digits = 0;
+    bits.clear();
+    // цифры разбираются прямо в окне [gptr, egptr) буфера; за пределами окна sgetc подкачивает следующее.
+    // У небуферизованного streambuf (std::cin при sync_with_stdio(true)) окно пустое:
+    // тогда окном служит один символ из sgetc, а забирается он через sbumpc
+    int next;
+    while (!stop && (next = in.sgetc()) != EOF) {
+        char single = static_cast<char>(next);
+        const char* begin = StreamWindow::begin(in);
+        const char* end = StreamWindow::end(in);
+        bool unbuffered = begin == end;
+        if (unbuffered) {
+            begin = &single;
+            end = begin + 1;
+        }
+        const char* pos = begin;
+        for (; pos != end; ++pos) {
+            unsigned digit = static_cast<unsigned char>(*pos) - '0';
+            if (digit > 9) {
+                if (*pos == '.' && fraction && !point) {
+                    point = true;
+                    point_digits = digits;
+                    continue;
+                }
+                stop = true;
+                break;
+            }
+            if (digits < head_digits) {
+                head = head * 10 + digit;
+                if (++digits == head_digits)
+                    for (unsigned long long divisor = 1000000000000ULL; divisor; divisor /= base)
+                        bits.push_back(head / divisor % base);
+                continue;
+            }
+            // целый разряд за раз, если он весь в окне
+            if (limb_digits == 0 && end - pos >= base_digits) {
+                unsigned d1 = static_cast<unsigned char>(pos[1]) - '0';
+                unsigned d2 = static_cast<unsigned char>(pos[2]) - '0';
+                unsigned d3 = static_cast<unsigned char>(pos[3]) - '0';
+                if (d1 <= 9 && d2 <= 9 && d3 <= 9) {
+                    bits.push_back(((digit * 10 + d1) * 10 + d2) * 10 + d3);
+                    digits += base_digits;
+                    pos += base_digits - 1;
+                    continue;
+                }
+            }
+            ++digits;
+            limb = limb * 10 + digit;
+            if (++limb_digits == base_digits) {
+                bits.push_back(limb);
+                limb = limb_digits = 0;
+            }
+        }
+        if (!unbuffered)
+            StreamWindow::skip(in, pos - begin);
+        else if (pos != begin)
+            in.sbumpc();
+    }
+    if (fraction)
+        *fraction = point ? digits - point_digits : 0;
+    if (digits == 0) {
+        if (point)
+            in.sputbackc('.');
+        if (sign == '-' || sign == '+')
+            in.sputbackc(static_cast<char>(sign));
+        *this = 0;
+        return false;
+    }
+    if (digits < head_digits) {
+        assign_abs(head, positive);
+        return true;
+    }
+    if (limb_digits)
+        bits.push_back(limb * small_pow10[base_digits - limb_digits]);
+    std::reverse(bits.begin(), bits.end());
+    is_small = false;
+    value = 0;
+    is_positive = positive;
+    // делитель — константа времени компиляции, иначе деление на каждый разряд медленное
+    if (base_digits - limb_digits == 1)
+        divide_exact<10>();
+    else if (base_digits - limb_digits == 2)
+        divide_exact<100>();
+    else if (base_digits - limb_digits == 3)
+        divide_exact<1000>();
+    normalize();
+    return true;
+}
+template <int divisor>
+void BigInteger::divide_exact() {
+    int rest = 0;
+    for (int i = get_size() - 1; i >= 0; --i) {
+        int current = rest * base + bits[i];
+        bits[i] = current / divisor;
+        rest = current % divisor;
+    }
+}
 
 string BigInteger::toString() const {
+    if (is_small)
+        return to_string(value);
+    // строка выделяется один раз, разряды пишутся в неё с ведущими нулями
     string s;
-    if (!is_positive) s += "-";
-    for (int i = get_size() - 1; i >= 0; --i) {
-        if (i != get_size() - 1 && bits[i] == 0)
-            s += "0000";
-        else if (i == get_size() - 1)
-            s += to_string(bits[i]);
-        else {
-            if (bits[i] > 999)
-                s += to_string(bits[i]);
-            else if (bits[i] > 99)
-                s += "0" + to_string(bits[i]);
-            else if (bits[i] > 9)
-                s += "00" + to_string(bits[i]);
-            else if (bits[i] > 0)
-                s += "000" + to_string(bits[i]);
-        }
+    s.reserve(get_size() * base_digits + 1);
+    if (!is_positive) s += '-';
+    s += to_string(bits.back());
+    for (int i = get_size() - 2; i >= 0; --i) {
+        char digits[base_digits];
+        int limb = bits[i];
+        for (int j = base_digits - 1; j >= 0; --j, limb /= 10)
+            digits[j] = static_cast<char>('0' + limb % 10);
+        s.append(digits, base_digits);
     }
     return s;
 }
 
 
+/////////////    BINARY FORMAT    /////////////
+// Версия 1. Число начинается с varint-заголовка h: h & 1 — знак минус.
+// Если h & 2, то h >> 2 — количество разрядов, и дальше идут разряды по 14 бит,
+// упакованные little-endian; иначе дальше идёт модуль одним varint.
+// Пакет чисел: "BIN", байт версии, varint количества, затем сами числа.
+const char binary_format_magic[] = "BIN";
+const unsigned char binary_format_version = 1;
+const size_t binary_read_chunk = 1 << 16;
+
+void write_varint(string& out, unsigned long long num) {
+    while (num >= 0x80) {
+        out.push_back(static_cast<char>((num & 0x7F) | 0x80));
+        num >>= 7;
+    }
+    out.push_back(static_cast<char>(num));
+}
+// возвращает количество прочитанных байт, 0 — ошибка
+size_t read_varint(const char* data, size_t size, unsigned long long& num) {
+    num = 0;
+    for (size_t i = 0; i < size && i < 10; ++i) {
+        unsigned long long byte = static_cast<unsigned char>(data[i]);
+        num |= (byte & 0x7F) << (7 * i);
+        if (!(byte & 0x80))
+            return i + 1;
+    }
+    return 0;
+}
+bool read_varint_bytes(std::streambuf& in, string& out) {
+    for (size_t i = 0; i < 10; ++i) {
+        int byte = in.sbumpc();
+        if (byte == EOF)
+            return false;
+        out.push_back(static_cast<char>(byte));
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+void BigInteger::appendBinary(string& out) const {
+    if (is_small) {
+        write_varint(out, value < 0 ? 1 : 0);
+        write_varint(out, value < 0 ? -static_cast<unsigned long long>(value) : value);
+        return;
+    }
+    write_varint(out, (static_cast<unsigned long long>(bits.size()) << 2) | 2 | (is_positive ? 0 : 1));
+    unsigned long long buffer = 0;
+    int filled = 0;
+    for (int limb : bits) {
+        buffer |= static_cast<unsigned long long>(limb) << filled;
+        for (filled += 14; filled >= 8; filled -= 8) {
+            out.push_back(static_cast<char>(buffer & 0xFF));
+            buffer >>= 8;
+        }
+    }
+    if (filled)
+        out.push_back(static_cast<char>(buffer));
+}
+// разряды пишутся сразу в bits; возвращает количество прочитанных байт, 0 — ошибка
+size_t BigInteger::parseBinary(const char* data, size_t size) {
+    unsigned long long header;
+    size_t pos = read_varint(data, size, header);
+    if (!pos) return 0;
+    if (!(header & 2)) {
+        unsigned long long abs_value;
+        size_t length = read_varint(data + pos, size - pos, abs_value);
+        if (!length) return 0;
+        assign_abs(abs_value, !(header & 1));
+        return pos + length;
+    }
+    unsigned long long count = header >> 2;
+    if (count == 0 || count > (size - pos) * 8 / 14)
+        return 0;
+    size_t bytes = (count * 14 + 7) / 8;
+    const unsigned char* input = reinterpret_cast<const unsigned char*>(data + pos);
+    is_small = false;
+    value = 0;
+    is_positive = !(header & 1);
+    bits.resize(count);
+    unsigned long long buffer = 0;
+    int filled = 0;
+    for (size_t i = 0; i < count; ++i) {
+        for (; filled < 14; filled += 8)
+            buffer |= static_cast<unsigned long long>(*input++) << filled;
+        bits[i] = static_cast<int>(buffer & 0x3FFF);
+        buffer >>= 14;
+        filled -= 14;
+        if (bits[i] >= base) {
+            *this = 0;
+            return 0;
+        }
+    }
+    normalize();
+    return pos + bytes;
+}
+bool BigInteger::readBinary(std::streambuf& in, string& buffer) {
+    buffer.clear();
+    if (!read_varint_bytes(in, buffer))
+        return false;
+    unsigned long long header;
+    read_varint(buffer.data(), buffer.size(), header);
+    if (header & 2) {
+        // длина пришла из потока: буфер растёт порциями по мере поступления данных,
+        // так что испорченный заголовок не выделит память сверх реального размера входа
+        unsigned long long count = header >> 2;
+        if (count > (std::numeric_limits<size_t>::max() - 7) / 14)
+            return false;
+        size_t bytes = (count * 14 + 7) / 8;
+        for (size_t done = 0; done < bytes;) {
+            size_t start = buffer.size();
+            size_t chunk = std::min(bytes - done, binary_read_chunk);
+            buffer.resize(start + chunk);
+            if (static_cast<size_t>(in.sgetn(&buffer[start], chunk)) != chunk)
+                return false;
+            done += chunk;
+        }
+    } else if (!read_varint_bytes(in, buffer))
+        return false;
+    return parseBinary(buffer.data(), buffer.size()) == buffer.size();
+}
+
+
+/*******************************************************/
+///////////////////   MODULAR   /////////////////////////
+/*******************************************************/
+
+BigInteger mod_inverse(const BigInteger&, const BigInteger&);
+
+// Контекст для арифметики по фиксированному модулю: константы Монтгомери
+// и Барретта считаются один раз в конструкторе
+class ModContext {
+private:
+    static const int base = BigInteger::base;
+    BigInteger mod;
+    vector<int> mod_bits;
+    size_t size = 0;
+    bool has_montgomery = false;
+    int mod_inverse = 0;    // -mod^(-1) по модулю base
+    BigInteger r2;          // base^(2 * size) mod mod
+    BigInteger barrett_mu;  // base^(2 * size) / mod
+    BigInteger barrett_bound;
+
+    static BigInteger slice_limbs(const BigInteger&, size_t, size_t);
+    BigInteger barrett(const BigInteger&) const;
+    static vector<int> to_binary(const BigInteger&);
+    BigInteger power_bits(const BigInteger&, const int*, size_t) const;
+    void montgomery_reduce(vector<long long>&) const;
+    friend BigIntegerBatch mod_batch(const BigIntegerBatch&, const ModContext&);
+    friend bool is_probable_prime(const BigInteger&);
+public:
+    explicit ModContext(const BigInteger&);
+
+    const BigInteger& modulus() const;
+    bool isMontgomery() const;
+
+    BigInteger reduce(const BigInteger&) const;
+    BigInteger mul(const BigInteger&, const BigInteger&) const;
+
+    BigInteger toMontgomery(const BigInteger&) const;
+    BigInteger fromMontgomery(const BigInteger&) const;
+    BigInteger montgomeryMul(const BigInteger&, const BigInteger&) const;
+
+    BigInteger powmod(const BigInteger&, const BigInteger&) const;
+};
+
+
+///////////   CONSTRUCTORS   ///////////
+ModContext::ModContext(const BigInteger& modulus): mod(modulus) {
+    if (mod < 1)
+        throw std::invalid_argument("ModContext: modulus must be positive");
+    BigInteger storage;
+    mod_bits = BigInteger::as_limbs(mod, storage).bits;
+    size = mod_bits.size();
+    BigInteger square_base = 1;
+    square_base.mul_pow10(2 * size * BigInteger::base_digits);
+    barrett_mu = square_base / mod;
+    barrett_bound = square_base;
+    // Монтгомери с R = base^size работает только для модулей, взаимно простых с base
+    if (mod > 1 && mod_bits[0] % 2 != 0 && mod_bits[0] % 5 != 0) {
+        has_montgomery = true;
+        int r0 = base, r1 = mod_bits[0], x0 = 0, x1 = 1;
+        while (r1) {
+            int q = r0 / r1;
+            std::swap(r0, r1);
+            r1 -= q * r0;
+            std::swap(x0, x1);
+            x1 -= q * x0;
+        }
+        mod_inverse = ((-x0) % base + base) % base;
+        r2 = reduce(square_base);
+    }
+}
+const BigInteger& ModContext::modulus() const {
+    return mod;
+}
+bool ModContext::isMontgomery() const {
+    return has_montgomery;
+}
+
+
+///////////    BARRETT    ///////////
+// разряды [begin, end) числа
+BigInteger ModContext::slice_limbs(const BigInteger& num, size_t begin, size_t end) {
+    BigInteger storage;
+    const BigInteger& limbs = BigInteger::as_limbs(num, storage);
+    end = std::min(end, limbs.bits.size());
+    if (begin >= end) return 0;
+    BigInteger result;
+    result.promote();
+    result.bits.assign(limbs.bits.begin() + begin, limbs.bits.begin() + end);
+    result.normalize();
+    return result;
+}
+// 0 <= num < barrett_bound
+BigInteger ModContext::barrett(const BigInteger& num) const {
+    if (num < mod)
+        return num;
+    BigInteger q = slice_limbs(num, size - 1, SIZE_MAX);
+    q *= barrett_mu;
+    q = slice_limbs(q, size + 1, SIZE_MAX);
+    BigInteger r = num - q * mod;
+    while (r >= mod)
+        r -= mod;
+    return r;
+}
+BigInteger ModContext::reduce(const BigInteger& num) const {
+    if (num < 0) {
+        BigInteger r = reduce(-num);
+        return r == 0 ? r : mod - r;
+    }
+    if (num < barrett_bound)
+        return barrett(num);
+    // длинное число — кусками по size разрядов от старших:
+    // остаток * base^size + кусок < mod * base^size <= barrett_bound
+    BigInteger storage;
+    size_t end = BigInteger::as_limbs(num, storage).bits.size();
+    BigInteger result = 0;
+    while (end > 0) {
+        size_t begin = end > size ? end - size : 0;
+        result.mul_pow10((end - begin) * BigInteger::base_digits);
+        result += slice_limbs(num, begin, end);
+        result = barrett(result);
+        end = begin;
+    }
+    return result;
+}
+BigInteger ModContext::mul(const BigInteger& num1, const BigInteger& num2) const {
+    return reduce(num1 * num2);
+}
+
+
+///////////    MONTGOMERY    ///////////
+// Разряды копятся в long long без переносов: в каждую ячейку попадает меньше 2 * size
+// произведений меньше base^2, так что переполнения нет при size до 4 * 10^10.
+// Перенос из t[i] уходит в t[i + 1] один раз, когда строка i редукции закончена
+void ModContext::montgomery_reduce(vector<long long>& t) const {
+    // t содержит 2 * size + 1 разрядов, после редукции остаётся t / R
+    for (size_t i = 0; i < size; ++i) {
+        long long m = t[i] % base * mod_inverse % base;
+        for (size_t j = 0; j < size; ++j)
+            t[i + j] += m * mod_bits[j];
+        t[i + 1] += t[i] / base;
+    }
+    for (size_t i = size; i + 1 < t.size(); ++i) {
+        t[i + 1] += t[i] / base;
+        t[i] %= base;
+    }
+    t.erase(t.begin(), t.begin() + size);
+}
+// без Монтгомери (модуль не взаимно прост с base) форма совпадает с обычной.
+// Множители вне [0, mod) сначала приводятся: буфер t рассчитан на произведение меньше mod^2
+BigInteger ModContext::montgomeryMul(const BigInteger& num1, const BigInteger& num2) const {
+    if (!has_montgomery) return mul(num1, num2);
+    if (num1 < 0 || num1 >= mod || num2 < 0 || num2 >= mod)
+        return montgomeryMul(reduce(num1), reduce(num2));
+    BigInteger storage1, storage2;
+    const vector<int>& a = BigInteger::as_limbs(num1, storage1).bits;
+    const vector<int>& b = BigInteger::as_limbs(num2, storage2).bits;
+    vector<long long> t(2 * size + 1, 0);
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i] == 0) continue;
+        long long digit = a[i];
+        for (size_t j = 0; j < b.size(); ++j)
+            t[i + j] += digit * b[j];
+    }
+    montgomery_reduce(t);
+    BigInteger result;
+    result.promote();
+    result.bits.assign(t.begin(), t.end());
+    result.normalize();
+    if (result >= mod)
+        result -= mod;
+    return result;
+}
+BigInteger ModContext::toMontgomery(const BigInteger& num) const {
+    if (!has_montgomery) return reduce(num);
+    return montgomeryMul(reduce(num), r2);
+}
+BigInteger ModContext::fromMontgomery(const BigInteger& num) const {
+    if (!has_montgomery) return num;
+    return montgomeryMul(num, 1);
+}
+
+
+///////////    POWER    ///////////
+vector<int> ModContext::to_binary(const BigInteger& num) {
+    // младшими битами вперёд
+    vector<int> result;
+    for (unsigned word : BigInteger::to_words(num))
+        for (int i = 0; i < 32; ++i)
+            result.push_back((word >> i) & 1);
+    while (!result.empty() && result.back() == 0)
+        result.pop_back();
+    return result;
+}
+// перевод показателя в двоичный вид стоит O(n^2), поэтому он делается один раз,
+// а степень считается по готовым битам exp[0..size), младшими вперёд
+BigInteger ModContext::power_bits(const BigInteger& num, const int* exp, size_t size) const {
+    if (mod == 1) return 0;
+    if (size == 0) return 1;
+    size_t window = size > 512 ? 5 : size > 128 ? 4 : size > 16 ? 3 : 1;
+    BigInteger g = toMontgomery(num);
+    // нечётные степени g, g^3, ..., g^(2^window - 1)
+    vector<BigInteger> odd_powers(size_t(1) << (window - 1), g);
+    BigInteger g2 = montgomeryMul(g, g);
+    for (size_t i = 1; i < odd_powers.size(); ++i)
+        odd_powers[i] = montgomeryMul(odd_powers[i - 1], g2);
+    BigInteger result = toMontgomery(1);
+    long long i = static_cast<long long>(size) - 1;
+    while (i >= 0) {
+        if (exp[i] == 0) {
+            result = montgomeryMul(result, result);
+            --i;
+            continue;
+        }
+        long long j = std::max(i - static_cast<long long>(window) + 1, 0LL);
+        while (exp[j] == 0)
+            ++j;
+        int chunk = 0;
+        for (long long p = i; p >= j; --p) {
+            chunk = chunk * 2 + exp[p];
+            result = montgomeryMul(result, result);
+        }
+        result = montgomeryMul(result, odd_powers[chunk / 2]);
+        i = j - 1;
+    }
+    return fromMontgomery(result);
+}
+// отрицательная степень — степень обратного элемента; если его нет, бросается invalid_argument
+BigInteger ModContext::powmod(const BigInteger& num, const BigInteger& deg) const {
+    vector<int> exp = to_binary(deg);
+    if (deg >= 0 || mod == 1)
+        return power_bits(num, exp.data(), exp.size());
+    BigInteger inverse = ::mod_inverse(num, mod);
+    if (inverse == 0)
+        throw std::invalid_argument("ModContext::powmod: base is not invertible");
+    return power_bits(inverse, exp.data(), exp.size());
+}
+BigInteger powmod(const BigInteger& num, const BigInteger& deg, const BigInteger& mod) {
+    return ModContext(mod).powmod(num, deg);
+}
+
+
+/////    NUMBER THEORY    /////
+// целая часть корня степени deg из неотрицательного числа
+BigInteger iroot(const BigInteger& num, size_t deg) {
+    if (deg == 1 || num < 2) return num;
+    size_t length = num.bit_length();
+    if (deg >= length) return 1;
+    // корень из старшей половины битов даёт начальное приближение сверху
+    size_t shift = length / (2 * deg);
+    BigInteger x;
+    if (length <= 64 || shift == 0)
+        x = BigInteger(1) << ((length + deg - 1) / deg);
+    else
+        x = (iroot(num >> (shift * deg), deg) + 1) << shift;
+    // метод Ньютона, убывает к ответу
+    while (true) {
+        BigInteger power = x;
+        for (size_t i = 2; i < deg; ++i)
+            power *= x;
+        BigInteger next = x * BigInteger(deg - 1) + num / power;
+        next /= BigInteger(deg);
+        if (next >= x) return x;
+        x = next;
+    }
+}
+BigInteger isqrt(const BigInteger& num) {
+    return iroot(num, 2);
+}
+// достаточно проверить простые степени deg с 2^deg <= num: если num = a^(p*q), то num = (a^q)^p
+bool is_perfect_power(const BigInteger& num) {
+    if (num < 2) return num >= 0;
+    // 2^(length - 1) <= num < 2^length, поэтому подходят только deg < length
+    int length = static_cast<int>(std::min<size_t>(num.bit_length(), std::numeric_limits<int>::max()));
+    vector<bool> composite(length, false);
+    for (int deg = 2; deg < length; ++deg) {
+        if (composite[deg]) continue;
+        for (long long multiple = 1LL * deg * deg; multiple < length; multiple += deg)
+            composite[multiple] = true;
+        BigInteger root = iroot(num, static_cast<size_t>(deg));
+        if (pow(root, deg) == num) return true;
+    }
+    return false;
+}
+// Миллер — Рабин по первым 20 простым основаниям: детерминированно для num < 3.3 * 10^24
+bool is_probable_prime(const BigInteger& num) {
+    static const int small_primes[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53, 59, 61, 67, 71};
+    if (num < 2) return false;
+    for (int p : small_primes) {
+        if (num == p) return true;
+        if (num % p == 0) return false;
+    }
+    // num - 1 = d * 2^s: биты d — биты num - 1 без s младших нулей,
+    // так что num - 1 переводится в двоичный вид один раз на все основания
+    BigInteger minus_one = num - 1;
+    vector<int> bits = ModContext::to_binary(minus_one);
+    size_t s = 0;
+    while (bits[s] == 0)
+        ++s;
+    ModContext context(num);
+    for (int p : small_primes) {
+        BigInteger x = context.power_bits(p, bits.data() + s, bits.size() - s);
+        if (x == 1 || x == minus_one) continue;
+        bool composite = true;
+        for (size_t r = 1; r < s && composite; ++r) {
+            x = context.mul(x, x);
+            composite = x != minus_one;
+        }
+        if (composite) return false;
+    }
+    return true;
+}
+// обратный к num по модулю mod или 0, если его нет
+BigInteger mod_inverse(const BigInteger& num, const BigInteger& mod) {
+    BigInteger r0 = mod, r1 = num % mod;
+    if (r1 < 0) r1 += mod;
+    BigInteger x0 = 0, x1 = 1;
+    while (r1 != 0) {
+        BigInteger q = r0 / r1;
+        r0 -= q * r1;
+        std::swap(r0, r1);
+        x0 -= q * x1;
+        std::swap(x0, x1);
+    }
+    if (r0 != 1) return 0;
+    if (x0 < 0) x0 += mod;
+    return x0;
+}
+
+/*******************************************************/
+////////////////////   BATCH   //////////////////////////
+/*******************************************************/
+
+// Массив чисел в виде структуры массивов: разряды всех чисел лежат подряд
+// в одном буфере, операции идут поэлементно и делятся между потоками
+class BigIntegerBatch {
+private:
+    vector<int> limbs;
+    vector<size_t> offsets;
+    vector<size_t> sizes;
+    vector<char> negative;
+
+    void allocate(const vector<size_t>&);
+    void trim(size_t);
+    const int* data(size_t) const;
+    int* data(size_t);
+    static int compare_abs(const int*, size_t, const int*, size_t);
+    template <typename Function>
+    static void for_each_index(size_t, Function);
+public:
+    BigIntegerBatch() = default;
+    BigIntegerBatch(const vector<BigInteger>&);
+
+    size_t size() const;
+    BigInteger operator[](size_t) const;
+    vector<BigInteger> toVector() const;
+
+    friend BigIntegerBatch add_batch(const BigIntegerBatch&, const BigIntegerBatch&);
+    friend BigIntegerBatch mul_batch(const BigIntegerBatch&, const BigIntegerBatch&);
+    friend BigIntegerBatch mod_batch(const BigIntegerBatch&, const ModContext&);
+};
+
+
+///////////   CONSTRUCTORS   ///////////
+void BigIntegerBatch::allocate(const vector<size_t>& capacities) {
+    offsets.assign(capacities.size() + 1, 0);
+    for (size_t i = 0; i < capacities.size(); ++i)
+        offsets[i + 1] = offsets[i] + capacities[i];
+    limbs.assign(offsets.back(), 0);
+    sizes = capacities;
+    negative.assign(capacities.size(), 0);
+}
+BigIntegerBatch::BigIntegerBatch(const vector<BigInteger>& nums) {
+    vector<size_t> capacities(nums.size());
+    for (size_t i = 0; i < nums.size(); ++i)
+        capacities[i] = nums[i].is_small ? BigInteger::max_small_size : nums[i].bits.size();
+    allocate(capacities);
+    for (size_t i = 0; i < nums.size(); ++i) {
+        if (nums[i].is_small)
+            sizes[i] = BigInteger::small_limbs(nums[i].value, data(i));
+        else
+            std::copy(nums[i].bits.begin(), nums[i].bits.end(), data(i));
+        negative[i] = nums[i].is_negative();
+    }
+}
+
+
+/////////////    ACCESS    /////////////
+size_t BigIntegerBatch::size() const {
+    return sizes.size();
+}
+const int* BigIntegerBatch::data(size_t index) const {
+    return limbs.data() + offsets[index];
+}
+int* BigIntegerBatch::data(size_t index) {
+    return limbs.data() + offsets[index];
+}
+void BigIntegerBatch::trim(size_t index) {
+    const int* num = data(index);
+    while (sizes[index] > 1 && num[sizes[index] - 1] == 0)
+        --sizes[index];
+    if (sizes[index] == 1 && num[0] == 0)
+        negative[index] = 0;
+}
+BigInteger BigIntegerBatch::operator[](size_t index) const {
+    BigInteger result;
+    result.is_small = false;
+    result.bits.assign(data(index), data(index) + sizes[index]);
+    result.is_positive = !negative[index];
+    result.normalize();
+    return result;
+}
+vector<BigInteger> BigIntegerBatch::toVector() const {
+    vector<BigInteger> result(size());
+    for (size_t i = 0; i < size(); ++i)
+        result[i] = (*this)[i];
+    return result;
+}
+
+
+/////////////    MATHS    /////////////
+int BigIntegerBatch::compare_abs(const int* num1, size_t size1, const int* num2, size_t size2) {
+    if (size1 != size2)
+        return size1 < size2 ? -1 : 1;
+    for (size_t i = size1; i-- > 0;)
+        if (num1[i] != num2[i])
+            return num1[i] < num2[i] ? -1 : 1;
+    return 0;
+}
+template <typename Function>
+void BigIntegerBatch::for_each_index(size_t count, Function function) {
+    size_t threads = std::min<size_t>(BigInteger::getThreadCount(), count);
+    if (threads <= 1) {
+        for (size_t i = 0; i < count; ++i)
+            function(i);
+        return;
+    }
+    vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([=] {
+            for (size_t i = count * t / threads; i < count * (t + 1) / threads; ++i)
+                function(i);
+        });
+    }
+    for (std::thread& worker : workers)
+        worker.join();
+}
+
+BigIntegerBatch add_batch(const BigIntegerBatch& batch1, const BigIntegerBatch& batch2) {
+    size_t count = std::min(batch1.size(), batch2.size());
+    vector<size_t> capacities(count);
+    for (size_t i = 0; i < count; ++i)
+        capacities[i] = max(batch1.sizes[i], batch2.sizes[i]) + 1;
+    BigIntegerBatch result;
+    result.allocate(capacities);
+    BigIntegerBatch::for_each_index(count, [&](size_t i) {
+        const int* a = batch1.data(i);
+        const int* b = batch2.data(i);
+        size_t n = batch1.sizes[i], m = batch2.sizes[i];
+        bool negative = batch1.negative[i];
+        if (batch1.negative[i] != batch2.negative[i] && BigIntegerBatch::compare_abs(a, n, b, m) < 0) {
+            std::swap(a, b);
+            std::swap(n, m);
+            negative = batch2.negative[i];
+        }
+        int* out = result.data(i);
+        if (batch1.negative[i] == batch2.negative[i]) {
+            if (n < m) {
+                std::swap(a, b);
+                std::swap(n, m);
+            }
+            out[n] = BigInteger::add_kernel(out, a, n, b, m);
+        } else
+            BigInteger::sub_kernel(out, a, n, b, m);
+        result.negative[i] = negative;
+        result.trim(i);
+    });
+    return result;
+}
+BigIntegerBatch mul_batch(const BigIntegerBatch& batch1, const BigIntegerBatch& batch2) {
+    size_t count = std::min(batch1.size(), batch2.size());
+    vector<size_t> capacities(count);
+    for (size_t i = 0; i < count; ++i)
+        capacities[i] = batch1.sizes[i] + batch2.sizes[i];
+    BigIntegerBatch result;
+    result.allocate(capacities);
+    BigIntegerBatch::for_each_index(count, [&](size_t i) {
+        const int* a = batch1.data(i);
+        const int* b = batch2.data(i);
+        size_t n = batch1.sizes[i], m = batch2.sizes[i];
+        int* out = result.data(i);
+        if (std::min(n, m) >= BigInteger::karatsuba_threshold) {
+            vector<int> product = BigInteger::multiply_limbs(a, n, b, m, 1);
+            std::copy(product.begin(), product.end(), out);
+        } else {
+            for (size_t p = 0; p < n; ++p) {
+                int carry = 0;
+                for (size_t q = 0; q < m; ++q) {
+                    int cur = out[p + q] + a[p] * b[q] + carry;
+                    out[p + q] = cur % BigInteger::base;
+                    carry = cur / BigInteger::base;
+                }
+                out[p + m] = carry;
+            }
+        }
+        result.negative[i] = batch1.negative[i] != batch2.negative[i];
+        result.trim(i);
+    });
+    return result;
+}
+// остатки в [0, mod). Для одного делимого алгоритм D дешевле Барретта: тот делает
+// два полных умножения, поэтому разряды делятся прямо в буфере пакета
+BigIntegerBatch mod_batch(const BigIntegerBatch& batch, const ModContext& context) {
+    BigIntegerBatch result;
+    result.allocate(vector<size_t>(batch.size(), context.size));
+    const int* mod = context.mod_bits.data();
+    size_t size = context.size;
+    BigIntegerBatch::for_each_index(batch.size(), [&](size_t i) {
+        const int* a = batch.data(i);
+        size_t n = batch.sizes[i];
+        vector<int> quotient, rest;
+        if (BigIntegerBatch::compare_abs(a, n, mod, size) < 0)
+            rest.assign(a, a + n);
+        else
+            BigInteger::divmod_limbs(a, n, mod, size, quotient, rest);
+        while (rest.size() > 1 && rest.back() == 0)
+            rest.pop_back();
+        int* out = result.data(i);
+        result.sizes[i] = size;
+        // отрицательное делимое: mod - |остаток|, если остаток не ноль
+        if (batch.negative[i] && (rest.size() > 1 || rest[0] != 0))
+            BigInteger::sub_kernel(out, mod, size, rest.data(), rest.size());
+        else {
+            std::copy(rest.begin(), rest.end(), out);
+            result.sizes[i] = rest.size();
+        }
+        result.trim(i);
+    });
+    return result;
+}
+BigIntegerBatch mod_batch(const BigIntegerBatch& batch, const BigInteger& mod) {
+    return mod_batch(batch, ModContext(mod));
+}
+
 /*******************************************************/
 ///////////////////   RATIONAL   ////////////////////////
 /*******************************************************/
@@ -512,16 +2030,31 @@ class Rational {
 private:
     BigInteger numerator = 0;
     BigInteger denominator = 1;
+    // отрезок [lower, upper] вокруг значения по старшим разрядам; пересчитывается при
+    // каждом изменении дроби, так что сравнения его только читают и безопасны между потоками
+    double lower = 0;
+    double upper = 0;
+    bool has_bounds = true;
+    static std::atomic<bool> use_bounds;
     void simplify();
+    bool is_canonical() const;
     void swap(Rational&);
+    void update_bounds();
+    void flip_sign();
+    friend class RationalSum;
 public:
     Rational() = default;
     Rational(const BigInteger&, const BigInteger&);
     Rational(const int);
+    Rational(const Rational&) = default;
     ~Rational() = default;
 
     Rational& operator=(Rational);
 
+    // сравнения сначала смотрят на отрезки и умножают только при их пересечении
+    static void setIntervalCache(bool);
+    static bool getIntervalCache();
+
     explicit operator double() const;
     explicit operator bool() const;
     friend bool operator==(const Rational&, const Rational&);
@@ -543,13 +2076,19 @@ public:
 
     string asDecimal(size_t) const;
     string toString() const;
+
+    void appendBinary(string&) const;
+    size_t parseBinary(const char*, size_t);
+    bool readBinary(std::streambuf&, string&);
 };
 
 
 
 ///////////   CONSTRUCTORS   ///////////
+std::atomic<bool> Rational::use_bounds{true};
+
 void Rational::simplify() {
-    if (numerator == 0) denominator = 1;
+    if (!numerator) denominator = 1;
     else {
         BigInteger common = greatest_common_divisor(numerator, denominator);
         numerator /= common;
@@ -559,21 +2098,28 @@ void Rational::simplify() {
             denominator.change_sign();
         }
     }
+    update_bounds();
 }
 Rational::Rational(const BigInteger& num, const BigInteger& den = 1): numerator(num), denominator(den) {
-    if (num == 0) {
+    if (!num) {
         denominator = 1;
         return;
     }
     simplify();
 }
-Rational::Rational(const int n): Rational(n, 1) {}
+// целое уже несократимо: без gcd
+Rational::Rational(const int n): numerator(n) {
+    update_bounds();
+}
 
 
 /////////////   COPYING    /////////////
 void Rational::swap(Rational& q) {
     std::swap(numerator, q.numerator);
     std::swap(denominator, q.denominator);
+    std::swap(lower, q.lower);
+    std::swap(upper, q.upper);
+    std::swap(has_bounds, q.has_bounds);
 }
 Rational& Rational::operator=(Rational q) {
     swap(q);
@@ -590,25 +2136,82 @@ Rational::operator double() const{
     return answer;
 }
 Rational::operator bool() const {
-    return *this != 0;
+    return static_cast<bool>(numerator);
 }
 
 
 /////////////   LOGICAL    /////////////
+void Rational::setIntervalCache(bool enabled) {
+    use_bounds.store(enabled, std::memory_order_relaxed);
+}
+bool Rational::getIntervalCache() {
+    return use_bounds.load(std::memory_order_relaxed);
+}
+// p/q = head1 / head2 * 10^exponent * (1 +- 2e-12); запас берётся с избытком.
+// При выключенном кэше отрезок не считается, и такие дроби сравниваются точно
+void Rational::update_bounds() {
+    has_bounds = use_bounds.load(std::memory_order_relaxed);
+    if (!has_bounds)
+        return;
+    if (!numerator) {
+        lower = upper = 0;
+        return;
+    }
+    unsigned long long head1, head2;
+    size_t shift1, shift2;
+    numerator.leading_limbs(head1, shift1);
+    denominator.leading_limbs(head2, shift2);
+    long exponent = (static_cast<long>(shift1) - static_cast<long>(shift2)) * BigInteger::base_digits;
+    if (std::abs(exponent) > 280) {
+        // вне диапазона double остаётся только знак
+        lower = 0;
+        upper = std::numeric_limits<double>::infinity();
+    } else {
+        static const double error = 1e-11;
+        double value = static_cast<double>(head1) / static_cast<double>(head2) * std::pow(10.0, exponent);
+        lower = value * (1 - error);
+        upper = value * (1 + error);
+    }
+    if (numerator.is_negative()) {
+        std::swap(lower, upper);
+        lower = -lower;
+        upper = -upper;
+    }
+}
+// смена знака отражает отрезок, не пересчитывая его
+void Rational::flip_sign() {
+    numerator.change_sign();
+    std::swap(lower, upper);
+    lower = -lower;
+    upper = -upper;
+}
 bool operator==(const Rational& q1, const Rational& q2) {
+    if (q1.has_bounds && q2.has_bounds && Rational::getIntervalCache()) {
+        if (q1.upper < q2.lower || q2.upper < q1.lower)
+            return false;
+    }
     return (q1.numerator == q2.numerator) && (q1.denominator == q2.denominator);
 }
 bool operator!=(const Rational& q1, const Rational& q2) {
     return !(q1 == q2);
 }
+// знаменатели положительны, поэтому p1/q1 < p2/q2 <=> p1 * q2 < p2 * q1
 bool operator<(const Rational& q1, const Rational& q2) {
-    return q1.numerator * q2.numerator < q2.denominator * q1.denominator;
+    if (q1.has_bounds && q2.has_bounds && Rational::getIntervalCache()) {
+        if (q1.upper < q2.lower)
+            return true;
+        if (q1.lower >= q2.upper)
+            return false;
+    }
+    if (q1.denominator == q2.denominator)
+        return q1.numerator < q2.numerator;
+    return q1.numerator * q2.denominator < q2.numerator * q1.denominator;
 }
 bool operator<=(const Rational& q1, const Rational& q2) {
-    return (q1 == q2) || (q1 < q2);
+    return !(q2 < q1);
 }
 bool operator>(const Rational& q1, const Rational& q2) {
-    return !(q1 <= q2);
+    return q2 < q1;
 }
 bool operator>=(const Rational& q1, const Rational& q2) {
     return !(q1 < q2);
@@ -637,9 +2240,9 @@ Rational& Rational::operator-=(const Rational& q) {
         *this = 0;
         return *this;
     }
-    numerator.change_sign();
+    flip_sign();
     (*this) += q;
-    numerator.change_sign();
+    flip_sign();
     return *this;
 }
 Rational operator-(const Rational& q1, const Rational& q2) {
@@ -663,7 +2266,7 @@ Rational& Rational::operator/=(const Rational& q) {
         *this = 1;
         return *this;
     }
-    if (*this == 0)
+    if (!numerator)
         return *this;
     numerator *= q.denominator;
     denominator *= q.numerator;
@@ -679,24 +2282,33 @@ Rational operator/(const Rational& q1, const Rational& q2) {
 /////////////    BINARY    /////////////
 Rational Rational::operator-() const {
     Rational copy = *this;
-    if (*this == 0) return copy;
-    copy.numerator.change_sign();
+    copy.flip_sign();
     return copy;
 }
 
 
 /////////////    STREAM    /////////////
+// p, p/q или десятичная запись вида -12.375
 istream& operator >> (istream& in, Rational& q) {
-    int val;
-    in >> val;
-    q = val;
-    /*
-    string s, parse = "/";
-    in >> s;
-    q.numerator.parseString(s.substr(0, s.find(parse)));
-    q.denominator.parseString(s.substr(s.find(parse)+1));
-    q.simplify();
-    */
+    istream::sentry guard(in);
+    if (!guard)
+        return in;
+    std::streambuf& buffer = *in.rdbuf();
+    BigInteger numerator, denominator = 1;
+    size_t fraction;
+    bool ok = numerator.readDecimal(buffer, &fraction);
+    if (ok && fraction > 0)
+        denominator.mul_pow10(fraction);
+    else if (ok && buffer.sgetc() == '/') {
+        buffer.sbumpc();
+        ok = denominator.readDecimal(buffer) && denominator != 0;
+    }
+    if (ok)
+        q = Rational(numerator, denominator);
+    else
+        in.setstate(std::ios::failbit);
+    if (buffer.sgetc() == EOF)
+        in.setstate(std::ios::eofbit);
     return in;
 }
 ostream& operator << (ostream& out, const Rational& q) {
@@ -711,17 +2323,16 @@ string Rational::asDecimal(size_t precision = 0) const {
     if (numerator < 0)
         s += '-';
     BigInteger n = (numerator > 0 ? numerator : -numerator);
-    BigInteger tmp = n / denominator;
-    BigInteger remains = n % denominator;
-    s += tmp.toString();
+    // одно деление n * 10^precision на знаменатель вместо деления на каждую цифру
+    n.mul_pow10(precision);
+    n /= denominator;
+    string digits = n.toString();
+    if (digits.size() <= precision)
+        digits.insert(0, precision + 1 - digits.size(), '0');
+    s += digits.substr(0, digits.size() - precision);
     if (precision > 0) {
         s += '.';
-        for (size_t i = 0; i < precision; ++i) {
-            remains *= 10;
-            BigInteger t = remains / denominator;
-            s += t.toString();
-            remains %= denominator;
-        }
+        s += digits.substr(digits.size() - precision);
     }
     return s;
 }
@@ -730,3 +2341,192 @@ string Rational::toString() const {
         return numerator.toString();
     return numerator.toString() + "/" + denominator.toString();
 }
+
+
+/////////////    BINARY FORMAT    /////////////
+// числитель, затем знаменатель; дробь пишется уже сокращённой,
+// и несократимая запись при чтении отвергается: иначе 2/4 и 1/2 были бы разными числами
+bool Rational::is_canonical() const {
+    if (denominator <= 0) return false;
+    if (!numerator) return denominator == 1;
+    return denominator == 1 || greatest_common_divisor(numerator, denominator) == 1;
+}
+void Rational::appendBinary(string& out) const {
+    numerator.appendBinary(out);
+    denominator.appendBinary(out);
+}
+size_t Rational::parseBinary(const char* data, size_t size) {
+    size_t length1 = numerator.parseBinary(data, size);
+    size_t length2 = length1 ? denominator.parseBinary(data + length1, size - length1) : 0;
+    if (!length2 || !is_canonical()) {
+        *this = 0;
+        return 0;
+    }
+    update_bounds();
+    return length1 + length2;
+}
+bool Rational::readBinary(std::streambuf& in, string& buffer) {
+    if (!numerator.readBinary(in, buffer) || !denominator.readBinary(in, buffer) || !is_canonical()) {
+        *this = 0;
+        return false;
+    }
+    update_bounds();
+    return true;
+}
+
+template <typename Number>
+void writeBinary(ostream& out, const vector<Number>& nums) {
+    string buffer = binary_format_magic;
+    buffer.push_back(static_cast<char>(binary_format_version));
+    write_varint(buffer, nums.size());
+    for (const Number& num : nums)
+        num.appendBinary(buffer);
+    out.write(buffer.data(), buffer.size());
+}
+template <typename Number>
+bool readBinary(istream& in, vector<Number>& nums) {
+    std::streambuf& buf = *in.rdbuf();
+    string buffer(4, '\0');
+    if (buf.sgetn(&buffer[0], 4) != 4 || buffer.compare(0, 3, binary_format_magic) != 0 ||
+        static_cast<unsigned char>(buffer[3]) != binary_format_version) {
+        in.setstate(std::ios::failbit);
+        return false;
+    }
+    buffer.clear();
+    unsigned long long count;
+    if (!read_varint_bytes(buf, buffer) || !read_varint(buffer.data(), buffer.size(), count)) {
+        in.setstate(std::ios::failbit);
+        return false;
+    }
+    nums.clear();
+    nums.reserve(std::min<unsigned long long>(count, 1 << 16));
+    for (unsigned long long i = 0; i < count; ++i) {
+        nums.emplace_back();
+        if (!nums.back().readBinary(buf, buffer)) {
+            in.setstate(std::ios::failbit);
+            return false;
+        }
+    }
+    return true;
+}
+
+
+/*******************************************************/
+/////////////////   RATIONAL SUM   //////////////////////
+/*******************************************************/
+
+// Сумма многих дробей без сокращения на каждом шаге: слагаемые складываются
+// деревом, знаменатели объединяются через НОК, а дробь сокращается один раз в total().
+// Форма дерева зависит только от числа слагаемых, поэтому промежуточные
+// значения одинаковы при любом числе потоков
+class RationalSum {
+private:
+    static const size_t parallel_threshold = 256;
+    // несокращённая дробь
+    struct Partial {
+        BigInteger numerator;
+        BigInteger denominator;
+    };
+    vector<Partial> terms;
+
+    static void merge(Partial&, const Partial&);
+    Partial sum_range(size_t, size_t, unsigned) const;
+public:
+    RationalSum() = default;
+    RationalSum(const vector<Rational>&);
+
+    size_t size() const;
+    void clear();
+
+    RationalSum& operator+=(const Rational&);
+    RationalSum& operator-=(const Rational&);
+    // слагаемые другой суммы идут после своих, в том же порядке
+    RationalSum& operator+=(const RationalSum&);
+
+    Rational total() const;
+};
+
+
+///////////   CONSTRUCTORS   ///////////
+RationalSum::RationalSum(const vector<Rational>& nums) {
+    terms.reserve(nums.size());
+    for (const Rational& q : nums)
+        *this += q;
+}
+
+
+/////////////    ACCESS    /////////////
+size_t RationalSum::size() const {
+    return terms.size();
+}
+void RationalSum::clear() {
+    terms.clear();
+}
+
+
+/////////////    MATHS    /////////////
+RationalSum& RationalSum::operator+=(const Rational& q) {
+    terms.push_back({q.numerator, q.denominator});
+    return *this;
+}
+RationalSum& RationalSum::operator-=(const Rational& q) {
+    terms.push_back({-q.numerator, q.denominator});
+    return *this;
+}
+RationalSum& RationalSum::operator+=(const RationalSum& sum) {
+    if (this == &sum) {
+        RationalSum copy = sum;
+        return *this += copy;
+    }
+    terms.insert(terms.end(), sum.terms.begin(), sum.terms.end());
+    return *this;
+}
+// a/b + c/d = (a * d/g + c * b/g) / (b * d/g), g = НОД(b, d); числитель не сокращается
+void RationalSum::merge(Partial& sum, const Partial& term) {
+    if (sum.denominator == term.denominator) {
+        sum.numerator += term.numerator;
+        return;
+    }
+    if (term.denominator == 1) {
+        sum.numerator += term.numerator * sum.denominator;
+        return;
+    }
+    if (sum.denominator == 1) {
+        sum.numerator = sum.numerator * term.denominator + term.numerator;
+        sum.denominator = term.denominator;
+        return;
+    }
+    BigInteger common = greatest_common_divisor(sum.denominator, term.denominator);
+    if (common == 1) {
+        sum.numerator = sum.numerator * term.denominator + term.numerator * sum.denominator;
+        sum.denominator *= term.denominator;
+        return;
+    }
+    BigInteger factor = term.denominator / common;
+    sum.numerator = sum.numerator * factor + term.numerator * (sum.denominator / common);
+    sum.denominator *= factor;
+}
+// половины диапазона считаются в разных потоках, но объединяются всегда левая с правой
+RationalSum::Partial RationalSum::sum_range(size_t begin, size_t end, unsigned threads) const {
+    if (end - begin == 1)
+        return terms[begin];
+    size_t middle = begin + (end - begin) / 2;
+    Partial left, right;
+    if (threads > 1 && end - begin >= parallel_threshold) {
+        unsigned left_threads = threads / 2;
+        std::thread worker([&] { left = sum_range(begin, middle, left_threads); });
+        right = sum_range(middle, end, threads - left_threads);
+        worker.join();
+    } else {
+        left = sum_range(begin, middle, 1);
+        right = sum_range(middle, end, 1);
+    }
+    merge(left, right);
+    return left;
+}
+Rational RationalSum::total() const {
+    if (terms.empty())
+        return 0;
+    Partial sum = sum_range(0, terms.size(), BigInteger::getThreadCount());
+    return Rational(sum.numerator, sum.denominator);
+}
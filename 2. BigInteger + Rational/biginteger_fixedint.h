@@ -0,0 +1,32 @@
+#pragma once
+
+#include "biginteger.h"
+#include "fixedint.h"
+
+/*******************************************************/
+///////////////   BIGINTEGER <-> FIXED INT   ////////////
+/*******************************************************/
+
+// Оба заголовка самостоятельны: biginteger.h сдаётся одним файлом, а fixedint.h
+// подключается рядом с matrix.h. Преобразования между ними нужны обоим, поэтому
+// живут здесь, а в BigInteger объявлены только их сигнатуры
+
+template <size_t Bits>
+BigInteger::BigInteger(const FixedInt<Bits>& num) {
+    FixedInt<Bits> abs_value = num < 0 ? -num : num;
+    vector<unsigned> words(Bits / 32);
+    for (size_t i = 0; i < words.size(); ++i)
+        words[i] = abs_value.word(i);
+    *this = from_words(words.data(), words.size(), !(num < 0));
+}
+// по модулю 2^Bits, как приведение к int
+template <size_t Bits>
+BigInteger::operator FixedInt<Bits>() const {
+    vector<unsigned> words = to_words(*this);
+    FixedInt<Bits> result;
+    for (size_t i = 0; i < words.size() && i < Bits / 32; ++i)
+        result.setWord(i, words[i]);
+    if (is_negative())
+        result.change_sign();
+    return result;
+}
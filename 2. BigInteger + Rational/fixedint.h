@@ -0,0 +1,518 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <array>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+
+using std::string;
+using std::ostream;
+using std::istream;
+
+/*******************************************************/
+/////////////////////   FIXED INT   /////////////////////
+/*******************************************************/
+
+// Целое ровно из Bits бит в дополнительном коде: переполнение заворачивается
+// по модулю 2^Bits, как у int. Слова по 32 бита лежат на стеке, младшие первыми;
+// циклы идут по константе size, так что при -O2 компилятор их разворачивает
+template <size_t Bits>
+class FixedInt {
+    static_assert(Bits % 32 == 0 && Bits >= 64, "FixedInt: Bits must be a multiple of 32, at least 64");
+private:
+    static constexpr size_t size = Bits / 32;
+    std::array<uint32_t, size> words{};
+    constexpr bool is_negative() const;
+    constexpr int compare_abs(const FixedInt<Bits>&) const;
+    constexpr bool less(const FixedInt<Bits>&) const;
+    constexpr uint32_t divmod_word(uint32_t);
+    constexpr void mul_add_word(uint32_t, uint32_t);
+    static constexpr void divmod_abs(const FixedInt<Bits>&, const FixedInt<Bits>&, FixedInt<Bits>&, FixedInt<Bits>&);
+    constexpr void divmod(const FixedInt<Bits>&, FixedInt<Bits>&);
+public:
+    constexpr FixedInt() = default;
+    constexpr FixedInt(int);
+    constexpr FixedInt(long);
+    constexpr FixedInt(long long);
+    constexpr FixedInt(unsigned);
+    constexpr FixedInt(unsigned long);
+    constexpr FixedInt(unsigned long long);
+    explicit FixedInt(const string&);
+
+    // слова дополнительного кода, младшие первыми
+    constexpr uint32_t word(size_t) const;
+    constexpr FixedInt<Bits>& setWord(size_t, uint32_t);
+
+    constexpr FixedInt<Bits>& change_sign();
+    constexpr explicit operator bool() const;
+    constexpr bool isEven() const;
+
+    constexpr FixedInt<Bits>& operator+=(const FixedInt<Bits>&);
+    constexpr FixedInt<Bits>& operator-=(const FixedInt<Bits>&);
+    constexpr FixedInt<Bits>& operator*=(const FixedInt<Bits>&);
+    constexpr FixedInt<Bits>& operator/=(const FixedInt<Bits>&);
+    constexpr FixedInt<Bits>& operator%=(const FixedInt<Bits>&);
+
+    // сдвиги и битовые операции как у int; >> округляет вниз
+    constexpr FixedInt<Bits>& operator<<=(size_t);
+    constexpr FixedInt<Bits>& operator>>=(size_t);
+    constexpr FixedInt<Bits>& operator&=(const FixedInt<Bits>&);
+    constexpr FixedInt<Bits>& operator|=(const FixedInt<Bits>&);
+    constexpr FixedInt<Bits>& operator^=(const FixedInt<Bits>&);
+    // по модулю числа
+    constexpr size_t popcount() const;
+    constexpr size_t bit_length() const;
+    constexpr size_t ctz() const;
+
+    constexpr FixedInt<Bits> operator-() const;
+    constexpr FixedInt<Bits>& operator++();
+    constexpr FixedInt<Bits>& operator--();
+    constexpr FixedInt<Bits> operator++(int);
+    constexpr FixedInt<Bits> operator--(int);
+
+    FixedInt<Bits>& parseString(const string&);
+    string toString() const;
+
+    // бинарные операторы определены здесь же, чтобы работали и x + 1, и 1 + x, как у BigInteger
+    friend constexpr bool operator==(const FixedInt<Bits>& num1, const FixedInt<Bits>& num2) { return num1.compare_abs(num2) == 0; }
+    friend constexpr bool operator!=(const FixedInt<Bits>& num1, const FixedInt<Bits>& num2) { return !(num1 == num2); }
+    friend constexpr bool operator<(const FixedInt<Bits>& num1, const FixedInt<Bits>& num2) { return num1.less(num2); }
+    friend constexpr bool operator<=(const FixedInt<Bits>& num1, const FixedInt<Bits>& num2) { return !num2.less(num1); }
+    friend constexpr bool operator>(const FixedInt<Bits>& num1, const FixedInt<Bits>& num2) { return num2.less(num1); }
+    friend constexpr bool operator>=(const FixedInt<Bits>& num1, const FixedInt<Bits>& num2) { return !num1.less(num2); }
+    friend constexpr FixedInt<Bits> operator+(FixedInt<Bits> num1, const FixedInt<Bits>& num2) { return num1 += num2; }
+    friend constexpr FixedInt<Bits> operator-(FixedInt<Bits> num1, const FixedInt<Bits>& num2) { return num1 -= num2; }
+    friend constexpr FixedInt<Bits> operator*(FixedInt<Bits> num1, const FixedInt<Bits>& num2) { return num1 *= num2; }
+    friend constexpr FixedInt<Bits> operator/(FixedInt<Bits> num1, const FixedInt<Bits>& num2) { return num1 /= num2; }
+    friend constexpr FixedInt<Bits> operator%(FixedInt<Bits> num1, const FixedInt<Bits>& num2) { return num1 %= num2; }
+    friend constexpr FixedInt<Bits> operator&(FixedInt<Bits> num1, const FixedInt<Bits>& num2) { return num1 &= num2; }
+    friend constexpr FixedInt<Bits> operator|(FixedInt<Bits> num1, const FixedInt<Bits>& num2) { return num1 |= num2; }
+    friend constexpr FixedInt<Bits> operator^(FixedInt<Bits> num1, const FixedInt<Bits>& num2) { return num1 ^= num2; }
+};
+
+
+///////////   CONSTRUCTORS   ///////////
+template <size_t Bits>
+constexpr FixedInt<Bits>::FixedInt(int num): FixedInt(static_cast<long long>(num)) {}
+template <size_t Bits>
+constexpr FixedInt<Bits>::FixedInt(long num): FixedInt(static_cast<long long>(num)) {}
+template <size_t Bits>
+constexpr FixedInt<Bits>::FixedInt(long long num) {
+    uint32_t fill = num < 0 ? UINT32_MAX : 0;
+    words[0] = static_cast<uint32_t>(num);
+    words[1] = static_cast<uint32_t>(static_cast<unsigned long long>(num) >> 32);
+    for (size_t i = 2; i < size; ++i)
+        words[i] = fill;
+}
+template <size_t Bits>
+constexpr FixedInt<Bits>::FixedInt(unsigned num): FixedInt(static_cast<unsigned long long>(num)) {}
+template <size_t Bits>
+constexpr FixedInt<Bits>::FixedInt(unsigned long num): FixedInt(static_cast<unsigned long long>(num)) {}
+template <size_t Bits>
+constexpr FixedInt<Bits>::FixedInt(unsigned long long num) {
+    words[0] = static_cast<uint32_t>(num);
+    words[1] = static_cast<uint32_t>(num >> 32);
+}
+template <size_t Bits>
+FixedInt<Bits>::FixedInt(const string& s) {
+    parseString(s);
+}
+
+
+/////////////    ACCESS    /////////////
+template <size_t Bits>
+constexpr uint32_t FixedInt<Bits>::word(size_t index) const {
+    return words[index];
+}
+template <size_t Bits>
+constexpr FixedInt<Bits>& FixedInt<Bits>::setWord(size_t index, uint32_t value) {
+    words[index] = value;
+    return *this;
+}
+
+
+/////////////    CAST     /////////////
+template <size_t Bits>
+constexpr FixedInt<Bits>::operator bool() const {
+    for (size_t i = 0; i < size; ++i)
+        if (words[i])
+            return true;
+    return false;
+}
+
+
+/////////////   LOGICAL    /////////////
+template <size_t Bits>
+constexpr bool FixedInt<Bits>::is_negative() const {
+    return words[size - 1] >> 31;
+}
+// сравнение слов как беззнаковых чисел
+template <size_t Bits>
+constexpr int FixedInt<Bits>::compare_abs(const FixedInt<Bits>& num) const {
+    for (size_t i = size; i-- > 0;)
+        if (words[i] != num.words[i])
+            return words[i] < num.words[i] ? -1 : 1;
+    return 0;
+}
+template <size_t Bits>
+constexpr bool FixedInt<Bits>::less(const FixedInt<Bits>& num) const {
+    if (is_negative() != num.is_negative())
+        return is_negative();
+    return compare_abs(num) < 0;
+}
+template <size_t Bits>
+constexpr bool FixedInt<Bits>::isEven() const {
+    return !(words[0] & 1);
+}
+
+
+/////////////    STREAM    /////////////
+template <size_t Bits>
+istream& operator >> (istream& in, FixedInt<Bits>& num) {
+    string s;
+    in >> s;
+    num.parseString(s);
+    return in;
+}
+template <size_t Bits>
+ostream& operator << (ostream& out, const FixedInt<Bits>& num) {
+    out << num.toString();
+    return out;
+}
+
+
+/////////////    MATHS    /////////////
+template <size_t Bits>
+constexpr FixedInt<Bits>& FixedInt<Bits>::operator+=(const FixedInt<Bits>& num) {
+    uint64_t carry = 0;
+    for (size_t i = 0; i < size; ++i) {
+        carry += static_cast<uint64_t>(words[i]) + num.words[i];
+        words[i] = static_cast<uint32_t>(carry);
+        carry >>= 32;
+    }
+    return *this;
+}
+template <size_t Bits>
+constexpr FixedInt<Bits>& FixedInt<Bits>::operator-=(const FixedInt<Bits>& num) {
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < size; ++i) {
+        uint64_t cur = static_cast<uint64_t>(words[i]) - num.words[i] - borrow;
+        words[i] = static_cast<uint32_t>(cur);
+        borrow = cur >> 63;
+    }
+    return *this;
+}
+// младшие size слов произведения: слагаемые старше 2^Bits не считаются
+template <size_t Bits>
+constexpr FixedInt<Bits>& FixedInt<Bits>::operator*=(const FixedInt<Bits>& num) {
+    std::array<uint32_t, size> result{};
+    for (size_t i = 0; i < size; ++i) {
+        if (!words[i])
+            continue;
+        uint64_t carry = 0;
+        for (size_t j = 0; i + j < size; ++j) {
+            carry += static_cast<uint64_t>(words[i]) * num.words[j] + result[i + j];
+            result[i + j] = static_cast<uint32_t>(carry);
+            carry >>= 32;
+        }
+    }
+    words = result;
+    return *this;
+}
+// делит беззнаковое значение на слово, возвращает остаток
+template <size_t Bits>
+constexpr uint32_t FixedInt<Bits>::divmod_word(uint32_t divisor) {
+    uint64_t rest = 0;
+    for (size_t i = size; i-- > 0;) {
+        uint64_t cur = (rest << 32) | words[i];
+        words[i] = static_cast<uint32_t>(cur / divisor);
+        rest = cur % divisor;
+    }
+    return static_cast<uint32_t>(rest);
+}
+template <size_t Bits>
+constexpr void FixedInt<Bits>::mul_add_word(uint32_t mul, uint32_t add) {
+    uint64_t carry = add;
+    for (size_t i = 0; i < size; ++i) {
+        carry += static_cast<uint64_t>(words[i]) * mul;
+        words[i] = static_cast<uint32_t>(carry);
+        carry >>= 32;
+    }
+}
+// Кнут, алгоритм D, над беззнаковыми значениями: num1 = quotient * num2 + remainder
+template <size_t Bits>
+constexpr void FixedInt<Bits>::divmod_abs(const FixedInt<Bits>& num1, const FixedInt<Bits>& num2,
+                                          FixedInt<Bits>& quotient, FixedInt<Bits>& remainder) {
+    size_t n = size, m = size;
+    while (n > 0 && num2.words[n - 1] == 0) --n;
+    while (m > 0 && num1.words[m - 1] == 0) --m;
+    quotient = FixedInt<Bits>();
+    remainder = num1;
+    if (n <= 1) { // на ноль делит как int
+        quotient = num1;
+        remainder = FixedInt<Bits>(quotient.divmod_word(num2.words[0]));
+        return;
+    }
+    if (m < n || num1.compare_abs(num2) < 0)
+        return;
+    // нормализация: старший бит делителя равен 1
+    int shift = __builtin_clz(num2.words[n - 1]);
+    std::array<uint32_t, size> divisor{};
+    std::array<uint32_t, size + 1> rest{};
+    for (size_t i = n - 1; i > 0; --i)
+        divisor[i] = (num2.words[i] << shift) | static_cast<uint32_t>(static_cast<uint64_t>(num2.words[i - 1]) >> (32 - shift));
+    divisor[0] = num2.words[0] << shift;
+    rest[m] = static_cast<uint32_t>(static_cast<uint64_t>(num1.words[m - 1]) >> (32 - shift));
+    for (size_t i = m - 1; i > 0; --i)
+        rest[i] = (num1.words[i] << shift) | static_cast<uint32_t>(static_cast<uint64_t>(num1.words[i - 1]) >> (32 - shift));
+    rest[0] = num1.words[0] << shift;
+    for (size_t j = m - n + 1; j-- > 0;) {
+        uint64_t top = (static_cast<uint64_t>(rest[j + n]) << 32) | rest[j + n - 1];
+        uint64_t guess = top / divisor[n - 1], guess_rest = top % divisor[n - 1];
+        while (guess >> 32 || guess * divisor[n - 2] > ((guess_rest << 32) | rest[j + n - 2])) {
+            --guess;
+            guess_rest += divisor[n - 1];
+            if (guess_rest >> 32)
+                break;
+        }
+        int64_t borrow = 0;
+        for (size_t i = 0; i < n; ++i) {
+            uint64_t product = guess * divisor[i];
+            int64_t cur = static_cast<int64_t>(rest[i + j]) - borrow - static_cast<int64_t>(product & UINT32_MAX);
+            rest[i + j] = static_cast<uint32_t>(cur);
+            borrow = static_cast<int64_t>(product >> 32) - (cur >> 32);
+        }
+        int64_t cur = static_cast<int64_t>(rest[j + n]) - borrow;
+        rest[j + n] = static_cast<uint32_t>(cur);
+        if (cur < 0) { // угадали на единицу больше: добавляем делитель обратно
+            --guess;
+            uint64_t carry = 0;
+            for (size_t i = 0; i < n; ++i) {
+                carry += static_cast<uint64_t>(rest[i + j]) + divisor[i];
+                rest[i + j] = static_cast<uint32_t>(carry);
+                carry >>= 32;
+            }
+            rest[j + n] += static_cast<uint32_t>(carry);
+        }
+        quotient.words[j] = static_cast<uint32_t>(guess);
+    }
+    remainder = FixedInt<Bits>();
+    for (size_t i = 0; i < n; ++i)
+        remainder.words[i] = (rest[i] >> shift) | static_cast<uint32_t>(static_cast<uint64_t>(rest[i + 1]) << (32 - shift));
+}
+// *this становится частным, в remainder — остаток со знаком делимого, как у int
+template <size_t Bits>
+constexpr void FixedInt<Bits>::divmod(const FixedInt<Bits>& num, FixedInt<Bits>& remainder) {
+    bool negative = is_negative(), other_negative = num.is_negative();
+    FixedInt<Bits> quotient;
+    divmod_abs(negative ? -*this : *this, other_negative ? -num : num, quotient, remainder);
+    if (negative != other_negative)
+        quotient.change_sign();
+    if (negative)
+        remainder.change_sign();
+    *this = quotient;
+}
+template <size_t Bits>
+constexpr FixedInt<Bits>& FixedInt<Bits>::operator/=(const FixedInt<Bits>& num) {
+    FixedInt<Bits> remainder;
+    divmod(num, remainder);
+    return *this;
+}
+template <size_t Bits>
+constexpr FixedInt<Bits>& FixedInt<Bits>::operator%=(const FixedInt<Bits>& num) {
+    FixedInt<Bits> remainder;
+    divmod(num, remainder);
+    *this = remainder;
+    return *this;
+}
+
+
+/////////////    BITWISE    /////////////
+template <size_t Bits>
+constexpr FixedInt<Bits>& FixedInt<Bits>::operator<<=(size_t deg) {
+    if (deg >= Bits)
+        return *this = FixedInt<Bits>();
+    size_t shift_words = deg / 32, shift = deg % 32;
+    for (size_t i = size; i-- > 0;) {
+        uint32_t high = i >= shift_words ? words[i - shift_words] : 0;
+        uint32_t low = i > shift_words ? words[i - shift_words - 1] : 0;
+        words[i] = shift ? (high << shift) | (low >> (32 - shift)) : high;
+    }
+    return *this;
+}
+template <size_t Bits>
+constexpr FixedInt<Bits>& FixedInt<Bits>::operator>>=(size_t deg) {
+    uint32_t fill = is_negative() ? UINT32_MAX : 0;
+    if (deg >= Bits) {
+        words.fill(fill);
+        return *this;
+    }
+    size_t shift_words = deg / 32, shift = deg % 32;
+    for (size_t i = 0; i < size; ++i) {
+        uint32_t low = i + shift_words < size ? words[i + shift_words] : fill;
+        uint32_t high = i + shift_words + 1 < size ? words[i + shift_words + 1] : fill;
+        words[i] = shift ? (low >> shift) | (high << (32 - shift)) : low;
+    }
+    return *this;
+}
+template <size_t Bits>
+constexpr FixedInt<Bits>& FixedInt<Bits>::operator&=(const FixedInt<Bits>& num) {
+    for (size_t i = 0; i < size; ++i)
+        words[i] &= num.words[i];
+    return *this;
+}
+template <size_t Bits>
+constexpr FixedInt<Bits>& FixedInt<Bits>::operator|=(const FixedInt<Bits>& num) {
+    for (size_t i = 0; i < size; ++i)
+        words[i] |= num.words[i];
+    return *this;
+}
+template <size_t Bits>
+constexpr FixedInt<Bits>& FixedInt<Bits>::operator^=(const FixedInt<Bits>& num) {
+    for (size_t i = 0; i < size; ++i)
+        words[i] ^= num.words[i];
+    return *this;
+}
+template <size_t Bits>
+constexpr FixedInt<Bits> operator<<(const FixedInt<Bits>& num, size_t deg) {
+    FixedInt<Bits> copy = num;
+    copy <<= deg;
+    return copy;
+}
+template <size_t Bits>
+constexpr FixedInt<Bits> operator>>(const FixedInt<Bits>& num, size_t deg) {
+    FixedInt<Bits> copy = num;
+    copy >>= deg;
+    return copy;
+}
+template <size_t Bits>
+constexpr size_t FixedInt<Bits>::popcount() const {
+    FixedInt<Bits> abs_value = is_negative() ? -*this : *this;
+    size_t count = 0;
+    for (size_t i = 0; i < size; ++i)
+        count += __builtin_popcount(abs_value.words[i]);
+    return count;
+}
+template <size_t Bits>
+constexpr size_t FixedInt<Bits>::bit_length() const {
+    FixedInt<Bits> abs_value = is_negative() ? -*this : *this;
+    for (size_t i = size; i-- > 0;)
+        if (abs_value.words[i])
+            return 32 * i + 32 - __builtin_clz(abs_value.words[i]);
+    return 0;
+}
+template <size_t Bits>
+constexpr size_t FixedInt<Bits>::ctz() const {
+    // младшие нули у x и -x совпадают
+    for (size_t i = 0; i < size; ++i)
+        if (words[i])
+            return 32 * i + __builtin_ctz(words[i]);
+    return 0;
+}
+
+
+/////////////    BINARY    /////////////
+template <size_t Bits>
+constexpr FixedInt<Bits>& FixedInt<Bits>::change_sign() {
+    uint64_t carry = 1;
+    for (size_t i = 0; i < size; ++i) {
+        carry += static_cast<uint32_t>(~words[i]);
+        words[i] = static_cast<uint32_t>(carry);
+        carry >>= 32;
+    }
+    return *this;
+}
+template <size_t Bits>
+constexpr FixedInt<Bits> FixedInt<Bits>::operator-() const {
+    FixedInt<Bits> copy = *this;
+    copy.change_sign();
+    return copy;
+}
+
+
+/////    INCREMENT - DECREMENT    /////
+template <size_t Bits>
+constexpr FixedInt<Bits>& FixedInt<Bits>::operator++() {
+    return *this += 1;
+}
+template <size_t Bits>
+constexpr FixedInt<Bits>& FixedInt<Bits>::operator--() {
+    return *this -= 1;
+}
+template <size_t Bits>
+constexpr FixedInt<Bits> FixedInt<Bits>::operator++(int) {
+    FixedInt<Bits> tmp = *this;
+    ++(*this);
+    return tmp;
+}
+template <size_t Bits>
+constexpr FixedInt<Bits> FixedInt<Bits>::operator--(int) {
+    FixedInt<Bits> tmp = *this;
+    --(*this);
+    return tmp;
+}
+
+
+/////////////    PARSING    /////////////
+// по 9 цифр за умножение на слово; лишние старшие цифры заворачиваются по модулю 2^Bits
+template <size_t Bits>
+FixedInt<Bits>& FixedInt<Bits>::parseString(const string& s) {
+    static const uint32_t chunk_pow10[10] = {1, 10, 100, 1000, 10000, 100000, 1000000,
+                                             10000000, 100000000, 1000000000};
+    words.fill(0);
+    size_t pos = (!s.empty() && (s[0] == '-' || s[0] == '+')) ? 1 : 0;
+    while (pos < s.size()) {
+        size_t length = std::min<size_t>(9, s.size() - pos);
+        uint32_t chunk = 0;
+        for (size_t i = 0; i < length; ++i)
+            chunk = chunk * 10 + (s[pos + i] - '0');
+        mul_add_word(chunk_pow10[length], chunk);
+        pos += length;
+    }
+    if (!s.empty() && s[0] == '-')
+        change_sign();
+    return *this;
+}
+template <size_t Bits>
+string FixedInt<Bits>::toString() const {
+    FixedInt<Bits> abs_value = is_negative() ? -*this : *this;
+    if (!abs_value)
+        return "0";
+    // цифры по 9 с младших, затем разворот
+    string digits;
+    while (abs_value) {
+        uint32_t chunk = abs_value.divmod_word(1000000000);
+        for (int i = 0; i < 9; ++i, chunk /= 10)
+            digits += static_cast<char>('0' + chunk % 10);
+    }
+    while (digits.size() > 1 && digits.back() == '0')
+        digits.pop_back();
+    if (is_negative())
+        digits += '-';
+    return string(digits.rbegin(), digits.rend());
+}
+
+
+/////////////    LIMITS    /////////////
+// как у встроенных целых: по is_integer обобщённый код (например, Matrix::det)
+// выбирает алгоритмы без дробного деления
+namespace std {
+template <size_t Bits>
+class numeric_limits<FixedInt<Bits>> {
+public:
+    static constexpr bool is_specialized = true;
+    static constexpr bool is_signed = true;
+    static constexpr bool is_integer = true;
+    static constexpr bool is_exact = true;
+    static constexpr bool is_bounded = true;
+    static constexpr bool is_modulo = true;
+    static constexpr int radix = 2;
+    static constexpr int digits = static_cast<int>(Bits) - 1;
+    static constexpr FixedInt<Bits> min() { return FixedInt<Bits>().setWord(Bits / 32 - 1, 0x80000000u); }
+    static constexpr FixedInt<Bits> lowest() { return min(); }
+    static constexpr FixedInt<Bits> max() { return FixedInt<Bits>(-1).setWord(Bits / 32 - 1, 0x7FFFFFFFu); }
+};
+}
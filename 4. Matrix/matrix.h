@@ -2,6 +2,26 @@
 #include <sstream>
 #include <vector>
 #include <string>
+#include <cstdint>
+#include <algorithm>
+#include <cmath>
+#include <array>
+#include <type_traits>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <map>
+#include <climits>
+#include <limits>
+#include <stdexcept>
+#include <exception>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define MATRIX_AVX2_KERNELS
+#endif
 
 using std::vector;
 using std::max;
@@ -36,6 +56,10 @@ public:
     friend bool operator==(const BigInteger&, const BigInteger&);
     friend bool operator<(const BigInteger&, const BigInteger&);
     bool isEven() const;
+    // остаток от деления на mod в [0, mod), в том числе для отрицательных чисел
+    uint32_t remainder(uint32_t mod) const;
+    // число десятичных цифр модуля
+    size_t length() const;
 
     friend istream& operator >> (istream&, BigInteger&);
     friend ostream& operator << (ostream&, const BigInteger&);
@@ -180,6 +204,15 @@ bool BigInteger::lessAbs(const BigInteger& num) const {
 bool BigInteger::isEven() const {
     return (bits[0] % 2 == 0);
 }
+uint32_t BigInteger::remainder(uint32_t mod) const {
+    uint64_t result = 0;
+    for (size_t i = bits.size(); i-- > 0;)
+        result = (result * base + bits[i]) % mod;
+    return !is_positive && result ? mod - result : result;
+}
+size_t BigInteger::length() const {
+    return (bits.size() - 1) * 4 + to_string(bits.back()).size();
+}
 
 
 /////////////    STREAM    /////////////
@@ -517,6 +550,7 @@ public:
     Rational() = default;
     Rational(const BigInteger&, const BigInteger&);
     Rational(const int);
+    Rational(const Rational&) = default;
     ~Rational() = default;
 
     Rational& operator=(Rational);
@@ -542,6 +576,9 @@ public:
 
     string asDecimal(size_t) const;
     string toString() const;
+
+    const BigInteger& getNumerator() const;
+    const BigInteger& getDenominator() const;
 };
 
 
@@ -729,22 +766,55 @@ string Rational::toString() const {
         return numerator.toString();
     return numerator.toString() + "/" + denominator.toString();
 }
+const BigInteger& Rational::getNumerator() const {
+    return numerator;
+}
+const BigInteger& Rational::getDenominator() const {
+    return denominator;
+}
 
 
 /*******************************************************/
 /////////////////////   FINITE   ////////////////////////
 /*******************************************************/
 
+// -mod^(-1) mod 2^32 для нечётного mod: каждый шаг Ньютона удваивает число верных битов
+constexpr uint32_t montgomery_inverse(uint32_t mod) {
+    uint32_t inverse = mod;
+    for (int i = 0; i < 4; ++i)
+        inverse *= 2 - mod * inverse;
+    return 0u - inverse;
+}
+
 template <int N>
 class Finite {
+    static_assert(N > 0, "Finite<N> needs a positive modulus");
 private:
-    int n = 0;
+    // При нечётном N значение хранится в форме Монтгомери, n = x * 2^32 mod N,
+    // и умножение обходится без деления; при чётном — как есть
+    static constexpr bool montgomery = N % 2 == 1;
+    static constexpr uint32_t modulus = N;
+    static constexpr uint32_t inverse = montgomery ? montgomery_inverse(modulus) : 0;
+    static constexpr uint32_t r2 = (uint64_t(1) << 32) % modulus * ((uint64_t(1) << 32) % modulus) % modulus;
+    static constexpr uint32_t r3 = uint64_t(r2) * ((uint64_t(1) << 32) % modulus) % modulus;
+    uint32_t n = 0;
+    static constexpr uint32_t reduce(uint64_t);
+    static constexpr uint32_t multiply(uint32_t, uint32_t);
     void fix(long long n);
+
+    template <int P> friend void add_batch(Finite<P>*, const Finite<P>*, size_t);
+    template <int P> friend void sub_batch(Finite<P>*, const Finite<P>*, size_t);
+    template <int P> friend void mul_batch(Finite<P>*, const Finite<P>*, size_t);
+    template <int P> friend void scale_batch(Finite<P>*, const Finite<P>&, size_t);
+    template <int P> friend void axpy_batch(Finite<P>*, const Finite<P>*, const Finite<P>&, size_t);
+    template <int P> friend void gemm(Finite<P>*, size_t, const Finite<P>*, size_t, const Finite<P>*, size_t,
+                                      size_t, size_t, size_t);
 public:
     void swap(Finite<N>&);
 
     Finite() = default;
     Finite(int);
+    Finite(const Finite<N>&) = default;
     ~Finite() = default;
 
     Finite<N>& operator=(Finite<N>);
@@ -774,9 +844,25 @@ public:
 
 
 ///////////   CONSTRUCTORS   ///////////
+// x * 2^(-32) mod N для x < N * 2^32; результат меньше N.
+// Вычитание N без ветвления: при t < N разность t - N переполняется и min её отбрасывает
+template<int N>
+constexpr uint32_t Finite<N>::reduce(uint64_t x) {
+    uint32_t m = uint32_t(x) * inverse;
+    uint32_t t = (x + uint64_t(m) * modulus) >> 32;
+    return std::min(t, t - modulus);
+}
+template<int N>
+constexpr uint32_t Finite<N>::multiply(uint32_t a, uint32_t b) {
+    if (montgomery)
+        return reduce(uint64_t(a) * b);
+    return uint64_t(a) * b % modulus;
+}
 template<int N>
 void Finite<N>::fix(long long num) {
     n = ((num % N) + N) % N;
+    if (montgomery)
+        n = multiply(n, r2);
 }
 template<int N>
 Finite<N>::Finite(int val) {
@@ -805,19 +891,22 @@ ostream& operator<<(ostream& out, const Finite<N>& el) {
 
 
 /////////////    MATHS    /////////////
+// оба слагаемых меньше N < 2^31, так что хватает одного условного вычитания
 template<int N>
 Finite<N>& Finite<N>::operator+=(const Finite<N>& el) {
-    fix(n + el.n);
+    n += el.n;
+    n = std::min(n, n - modulus);
     return *this;
 }
 template<int N>
 Finite<N>& Finite<N>::operator-=(const Finite<N>& el) {
-    fix(n - el.n);
+    n -= el.n;
+    n = std::min(n, n + modulus);
     return *this;
 }
 template<int N>
 Finite<N>& Finite<N>::operator*=(const Finite<N>& el) {
-    fix((long long)n * el.n);
+    n = multiply(n, el.n);
     return *this;
 }
 template<int N> // N - простое число
@@ -854,10 +943,8 @@ Finite<N> operator/(const Finite<N>& el1, const Finite<N>& el2) {
 /////////////    BINARY    /////////////
 template <int N>
 Finite<N> Finite<N>::operator-() const {
-    Finite<N> copy = *this;
-    if (copy == 0) return copy;
-    copy.n = -copy.n;
-    copy.fix(copy.n);
+    Finite<N> copy;
+    copy.n = n ? modulus - n : 0;
     return copy;
 }
 
@@ -899,11 +986,11 @@ bool Finite<N>::operator!=(const Finite<N> &el) const {
 /////////////    CAST     /////////////
 template<int N>
 Finite<N>::operator int() const {
-    return n;
+    return montgomery ? reduce(n) : n;
 }
 template<int N>
 Finite<N>::operator double() const {
-    return (double)n;
+    return (double)(int)*this;
 }
 template<int N>
 Finite<N>::operator bool() const {
@@ -923,9 +1010,1570 @@ Finite<N> Finite<N>::binary_pow(size_t deg) const {
     }
     return result;
 }
+// Расширенный алгоритм Евклида вместо возведения в степень N - 2; N может быть
+// и составным, если значение с ним взаимно просто. В форме Монтгомери n = x * R,
+// обратное к n равно x^(-1) * R^(-1), и умножение на R^3 переводит его в x^(-1) * R
 template<int N>
 Finite<N> Finite<N>::get_opposite() const {
-    return binary_pow(N - 2);
+    uint32_t a = n, b = modulus;
+    long long x0 = 1, x1 = 0;
+    while (b) {
+        uint32_t q = a / b;
+        a -= q * b;
+        std::swap(a, b);
+        x0 -= q * x1;
+        std::swap(x0, x1);
+    }
+    Finite<N> result;
+    result.n = x0 < 0 ? x0 + modulus : x0;
+    if (montgomery)
+        result.n = multiply(result.n, r3);
+    return result;
+}
+// Обращение массива приёмом Монтгомери: префиксные произведения, одно обращение
+// и обратный проход, 3(n - 1) умножений вместо n обращений. Нули остаются нулями.
+// Буфер префиксов свой у каждого потока и только растёт, так что повторные вызовы не выделяют память
+template <typename Residue>
+void invert_batch_prefix(Residue* data, size_t count) {
+    static thread_local vector<Residue> prefix;
+    if (prefix.size() < count)
+        prefix.resize(count);
+    Residue product = 1;
+    for (size_t i = 0; i < count; ++i) {
+        prefix[i] = product;
+        if (data[i]) product *= data[i];
+    }
+    Residue inverse = product.get_opposite();
+    for (size_t i = count; i-- > 0;) {
+        if (!data[i]) continue;
+        Residue value = data[i];
+        data[i] = inverse * prefix[i];
+        inverse *= value;
+    }
+}
+template <int N>
+void invert_batch(Finite<N>* data, size_t count) {
+    invert_batch_prefix(data, count);
+}
+// для остальных полей — поэлементно
+template <typename Field>
+void invert_batch(Field* data, size_t count) {
+    for (size_t i = 0; i < count; ++i)
+        if (data[i]) data[i] = Field(1) / data[i];
+}
+
+
+/////////////    ARRAYS    /////////////
+// Поэлементные операции над строками: y += x, y -= x, y *= x, y *= a и y += a * x.
+// Для Finite<N> они идут блоками по 8 остатков через AVX2, если процессор его умеет
+#ifdef MATRIX_AVX2_KERNELS
+bool has_avx2() {
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+bool has_fma() {
+    static const bool supported = __builtin_cpu_supports("fma");
+    return supported;
+}
+// Умножение Монтгомери в 8 дорожках: _mm256_mul_epu32 берёт чётные 32-битные
+// дорожки, поэтому нечётные сдвигаются вниз и считаются вторым набором произведений
+__attribute__((target("avx2")))
+static inline __m256i montgomery_mul_avx2(__m256i a, __m256i b, __m256i mod, __m256i inverse) {
+    __m256i product_even = _mm256_mul_epu32(a, b);
+    __m256i product_odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+    __m256i m_even = _mm256_mul_epu32(product_even, inverse);
+    __m256i m_odd = _mm256_mul_epu32(product_odd, inverse);
+    __m256i t_even = _mm256_add_epi64(product_even, _mm256_mul_epu32(m_even, mod));
+    __m256i t_odd = _mm256_add_epi64(product_odd, _mm256_mul_epu32(m_odd, mod));
+    __m256i t = _mm256_blend_epi32(_mm256_srli_epi64(t_even, 32), t_odd, 0xAA);
+    return _mm256_min_epu32(t, _mm256_sub_epi32(t, mod));
+}
+// каждая функция обрабатывает целые блоки по 8 и возвращает, сколько элементов сделано
+__attribute__((target("avx2")))
+size_t add_mod_avx2(uint32_t* y, const uint32_t* x, uint32_t modulus, size_t count) {
+    const __m256i mod = _mm256_set1_epi32(modulus);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i sum = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i)),
+                                       _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i)));
+        sum = _mm256_min_epu32(sum, _mm256_sub_epi32(sum, mod));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(y + i), sum);
+    }
+    return i;
+}
+__attribute__((target("avx2")))
+size_t sub_mod_avx2(uint32_t* y, const uint32_t* x, uint32_t modulus, size_t count) {
+    const __m256i mod = _mm256_set1_epi32(modulus);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i diff = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i)),
+                                        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i)));
+        diff = _mm256_min_epu32(diff, _mm256_add_epi32(diff, mod));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(y + i), diff);
+    }
+    return i;
+}
+__attribute__((target("avx2")))
+size_t mul_mod_avx2(uint32_t* y, const uint32_t* x, uint32_t modulus, uint32_t inverse, size_t count) {
+    const __m256i mod = _mm256_set1_epi32(modulus);
+    const __m256i inv = _mm256_set1_epi32(inverse);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i product = montgomery_mul_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i)),
+                                              _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i)), mod, inv);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(y + i), product);
+    }
+    return i;
+}
+__attribute__((target("avx2")))
+size_t scale_mod_avx2(uint32_t* y, uint32_t a, uint32_t modulus, uint32_t inverse, size_t count) {
+    const __m256i mod = _mm256_set1_epi32(modulus);
+    const __m256i inv = _mm256_set1_epi32(inverse);
+    const __m256i factor = _mm256_set1_epi32(a);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i product = montgomery_mul_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i)),
+                                              factor, mod, inv);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(y + i), product);
+    }
+    return i;
+}
+__attribute__((target("avx2")))
+size_t axpy_mod_avx2(uint32_t* y, const uint32_t* x, uint32_t a, uint32_t modulus, uint32_t inverse, size_t count) {
+    const __m256i mod = _mm256_set1_epi32(modulus);
+    const __m256i inv = _mm256_set1_epi32(inverse);
+    const __m256i factor = _mm256_set1_epi32(a);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i product = montgomery_mul_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i)),
+                                              factor, mod, inv);
+        __m256i sum = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i)), product);
+        sum = _mm256_min_epu32(sum, _mm256_sub_epi32(sum, mod));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(y + i), sum);
+    }
+    return i;
+}
+#endif
+
+template <typename Field>
+void add_batch(Field* y, const Field* x, size_t count) {
+    for (size_t i = 0; i < count; ++i)
+        y[i] += x[i];
+}
+template <typename Field>
+void sub_batch(Field* y, const Field* x, size_t count) {
+    for (size_t i = 0; i < count; ++i)
+        y[i] -= x[i];
+}
+template <typename Field>
+void mul_batch(Field* y, const Field* x, size_t count) {
+    for (size_t i = 0; i < count; ++i)
+        y[i] *= x[i];
+}
+template <typename Field>
+void scale_batch(Field* y, const Field& a, size_t count) {
+    for (size_t i = 0; i < count; ++i)
+        y[i] *= a;
+}
+template <typename Field>
+void axpy_batch(Field* y, const Field* x, const Field& a, size_t count) {
+    for (size_t i = 0; i < count; ++i)
+        y[i] += x[i] * a;
+}
+
+// Finite<N> лежит в массиве как uint32_t подряд; сложение и вычитание векторизуются
+// при любом N, умножения — только в форме Монтгомери
+template <int N>
+void add_batch(Finite<N>* y, const Finite<N>* x, size_t count) {
+    static_assert(sizeof(Finite<N>) == sizeof(uint32_t), "Finite<N> must be a bare residue");
+    size_t i = 0;
+#ifdef MATRIX_AVX2_KERNELS
+    if (has_avx2())
+        i = add_mod_avx2(reinterpret_cast<uint32_t*>(y), reinterpret_cast<const uint32_t*>(x), Finite<N>::modulus, count);
+#endif
+    for (; i < count; ++i)
+        y[i] += x[i];
+}
+template <int N>
+void sub_batch(Finite<N>* y, const Finite<N>* x, size_t count) {
+    size_t i = 0;
+#ifdef MATRIX_AVX2_KERNELS
+    if (has_avx2())
+        i = sub_mod_avx2(reinterpret_cast<uint32_t*>(y), reinterpret_cast<const uint32_t*>(x), Finite<N>::modulus, count);
+#endif
+    for (; i < count; ++i)
+        y[i] -= x[i];
+}
+template <int N>
+void mul_batch(Finite<N>* y, const Finite<N>* x, size_t count) {
+    size_t i = 0;
+#ifdef MATRIX_AVX2_KERNELS
+    if (Finite<N>::montgomery && has_avx2())
+        i = mul_mod_avx2(reinterpret_cast<uint32_t*>(y), reinterpret_cast<const uint32_t*>(x),
+                         Finite<N>::modulus, Finite<N>::inverse, count);
+#endif
+    for (; i < count; ++i)
+        y[i] *= x[i];
+}
+template <int N>
+void scale_batch(Finite<N>* y, const Finite<N>& a, size_t count) {
+    size_t i = 0;
+#ifdef MATRIX_AVX2_KERNELS
+    if (Finite<N>::montgomery && has_avx2())
+        i = scale_mod_avx2(reinterpret_cast<uint32_t*>(y), a.n, Finite<N>::modulus, Finite<N>::inverse, count);
+#endif
+    for (; i < count; ++i)
+        y[i] *= a;
+}
+template <int N>
+void axpy_batch(Finite<N>* y, const Finite<N>* x, const Finite<N>& a, size_t count) {
+    size_t i = 0;
+#ifdef MATRIX_AVX2_KERNELS
+    if (Finite<N>::montgomery && has_avx2())
+        i = axpy_mod_avx2(reinterpret_cast<uint32_t*>(y), reinterpret_cast<const uint32_t*>(x), a.n,
+                          Finite<N>::modulus, Finite<N>::inverse, count);
+#endif
+    for (; i < count; ++i)
+        y[i] += x[i] * a;
+}
+
+
+/*******************************************************/
+///////////////////   DYN FINITE   //////////////////////
+/*******************************************************/
+
+// Модуль, известный только во время выполнения, и константы Монтгомери для него;
+// для чётного модуля остатки хранятся как есть, как у Finite<N>
+struct FiniteModulus {
+    uint32_t modulus;
+    uint32_t inverse;
+    uint32_t r2;
+    uint32_t r3;
+    bool montgomery;
+    // модуль от 2 до 2^31 - 1, как у Finite<N>: сумма двух остатков помещается в uint32_t
+    explicit FiniteModulus(uint32_t);
+private:
+    static uint32_t checked(uint32_t);
+};
+
+// Остаток по модулю, заданному во время выполнения, с тем же интерфейсом, что у Finite<N>.
+// Модуль не хранится в элементе: его задаёт объект DynFinite::Scope для текущего потока,
+// поэтому массив DynFinite — это те же uint32_t подряд, и Matrix работает с ним как с Finite<N>
+class DynFinite {
+private:
+    static thread_local const FiniteModulus* context;
+    uint32_t n = 0;
+    static uint32_t reduce(uint64_t, const FiniteModulus&);
+    static uint32_t multiply(uint32_t, uint32_t, const FiniteModulus&);
+    void fix(long long n);
+
+    friend void add_batch(DynFinite*, const DynFinite*, size_t);
+    friend void sub_batch(DynFinite*, const DynFinite*, size_t);
+    friend void mul_batch(DynFinite*, const DynFinite*, size_t);
+    friend void scale_batch(DynFinite*, const DynFinite&, size_t);
+    friend void axpy_batch(DynFinite*, const DynFinite*, const DynFinite&, size_t);
+    friend void gemm(DynFinite*, size_t, const DynFinite*, size_t, const DynFinite*, size_t, size_t, size_t, size_t);
+    friend class WorkStealingPool;
+public:
+    // пока объект жив, все DynFinite этого потока считаются по его модулю
+    class Scope {
+    private:
+        const FiniteModulus* previous;
+    public:
+        explicit Scope(const FiniteModulus&);
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+        ~Scope();
+    };
+    static const FiniteModulus& modulus();
+
+    void swap(DynFinite&);
+
+    DynFinite() = default;
+    DynFinite(int);
+    ~DynFinite() = default;
+
+    DynFinite(const DynFinite&) = default;
+    DynFinite& operator=(const DynFinite&) = default;
+
+    DynFinite& operator+=(const DynFinite&);
+    DynFinite& operator-=(const DynFinite&);
+    DynFinite& operator*=(const DynFinite&);
+    DynFinite& operator/=(const DynFinite&);
+
+    DynFinite operator-() const;
+
+    DynFinite& operator++();
+    DynFinite& operator--();
+    DynFinite operator++(int);
+    DynFinite operator--(int);
+
+    bool operator==(const DynFinite&) const;
+    bool operator!=(const DynFinite&) const;
+
+    explicit operator int() const;
+    explicit operator double() const;
+    explicit operator bool() const;
+
+    DynFinite binary_pow(size_t deg) const;
+    DynFinite get_opposite() const;
+};
+
+
+///////////   CONSTRUCTORS   ///////////
+uint32_t FiniteModulus::checked(uint32_t mod) {
+    if (mod < 2 || mod > uint32_t(INT_MAX))
+        throw std::invalid_argument("FiniteModulus: modulus must be in [2, 2^31)");
+    return mod;
+}
+FiniteModulus::FiniteModulus(uint32_t mod)
+    : modulus(checked(mod)), inverse(mod % 2 == 1 ? montgomery_inverse(mod) : 0),
+      r2((uint64_t(1) << 32) % mod * ((uint64_t(1) << 32) % mod) % mod),
+      r3(uint64_t(r2) * ((uint64_t(1) << 32) % mod) % mod), montgomery(mod % 2 == 1) {}
+
+thread_local const FiniteModulus* DynFinite::context = nullptr;
+
+DynFinite::Scope::Scope(const FiniteModulus& mod): previous(context) {
+    context = &mod;
+}
+DynFinite::Scope::~Scope() {
+    context = previous;
+}
+// без активного Scope модуль не задан
+const FiniteModulus& DynFinite::modulus() {
+    // проверка и в сборках с NDEBUG: без Scope элемент негде взять модуль
+    if (!context)
+        throw std::logic_error("DynFinite used without DynFinite::Scope");
+    return *context;
+}
+uint32_t DynFinite::reduce(uint64_t x, const FiniteModulus& mod) {
+    uint32_t m = uint32_t(x) * mod.inverse;
+    uint32_t t = (x + uint64_t(m) * mod.modulus) >> 32;
+    return std::min(t, t - mod.modulus);
+}
+uint32_t DynFinite::multiply(uint32_t a, uint32_t b, const FiniteModulus& mod) {
+    if (mod.montgomery)
+        return reduce(uint64_t(a) * b, mod);
+    return uint64_t(a) * b % mod.modulus;
+}
+void DynFinite::fix(long long num) {
+    const FiniteModulus& mod = modulus();
+    long long m = mod.modulus;
+    n = ((num % m) + m) % m;
+    if (mod.montgomery)
+        n = multiply(n, mod.r2, mod);
+}
+DynFinite::DynFinite(int val) {
+    fix(val);
+}
+
+
+/////////////   COPYING    /////////////
+void DynFinite::swap(DynFinite& el) {
+    std::swap(n, el.n);
+}
+
+
+/////////////    STREAM    /////////////
+ostream& operator<<(ostream& out, const DynFinite& el) {
+    out << (int)el;
+    return out;
+}
+
+
+/////////////    MATHS    /////////////
+DynFinite& DynFinite::operator+=(const DynFinite& el) {
+    uint32_t mod = modulus().modulus;
+    n += el.n;
+    n = std::min(n, n - mod);
+    return *this;
+}
+DynFinite& DynFinite::operator-=(const DynFinite& el) {
+    uint32_t mod = modulus().modulus;
+    n -= el.n;
+    n = std::min(n, n + mod);
+    return *this;
+}
+DynFinite& DynFinite::operator*=(const DynFinite& el) {
+    n = multiply(n, el.n, modulus());
+    return *this;
+}
+DynFinite& DynFinite::operator/=(const DynFinite& el) {
+    *this *= el.get_opposite();
+    return *this;
+}
+DynFinite operator+(const DynFinite& el1, const DynFinite& el2) {
+    DynFinite copy = el1;
+    copy += el2;
+    return copy;
+}
+DynFinite operator-(const DynFinite& el1, const DynFinite& el2) {
+    DynFinite copy = el1;
+    copy -= el2;
+    return copy;
+}
+DynFinite operator*(const DynFinite& el1, const DynFinite& el2) {
+    DynFinite copy = el1;
+    copy *= el2;
+    return copy;
+}
+DynFinite operator/(const DynFinite& el1, const DynFinite& el2) {
+    DynFinite copy = el1;
+    copy /= el2;
+    return copy;
+}
+
+
+/////////////    BINARY    /////////////
+DynFinite DynFinite::operator-() const {
+    DynFinite copy;
+    copy.n = n ? modulus().modulus - n : 0;
+    return copy;
+}
+
+
+/////    INCREMENT - DECREMENT    /////
+DynFinite& DynFinite::operator++() {
+    return *this += 1;
+}
+DynFinite& DynFinite::operator--() {
+    return *this -= 1;
+}
+DynFinite DynFinite::operator++(int) {
+    DynFinite tmp = *this;
+    ++(*this);
+    return tmp;
+}
+DynFinite DynFinite::operator--(int) {
+    DynFinite tmp = *this;
+    --(*this);
+    return tmp;
+}
+
+
+/////////////   LOGICAL    /////////////
+bool DynFinite::operator==(const DynFinite& el) const {
+    return n == el.n;
+}
+bool DynFinite::operator!=(const DynFinite& el) const {
+    return !(*this == el);
+}
+
+
+/////////////    CAST     /////////////
+DynFinite::operator int() const {
+    return modulus().montgomery ? reduce(n, modulus()) : n;
+}
+DynFinite::operator double() const {
+    return (double)(int)*this;
+}
+DynFinite::operator bool() const {
+    return n != 0;
+}
+
+
+///////    ADDITIONAL METHODS    ///////
+DynFinite DynFinite::binary_pow(size_t deg) const {
+    DynFinite result = 1;
+    DynFinite copy = *this;
+    while (deg) {
+        if (deg & 1) result *= copy;
+        copy *= copy;
+        deg >>= 1;
+    }
+    return result;
+}
+// как у Finite<N>: расширенный Евклид и перевод в форму Монтгомери умножением на R^3
+DynFinite DynFinite::get_opposite() const {
+    const FiniteModulus& mod = modulus();
+    uint32_t a = n, b = mod.modulus;
+    long long x0 = 1, x1 = 0;
+    while (b) {
+        uint32_t q = a / b;
+        a -= q * b;
+        std::swap(a, b);
+        x0 -= q * x1;
+        std::swap(x0, x1);
+    }
+    DynFinite result;
+    result.n = x0 < 0 ? x0 + mod.modulus : x0;
+    if (mod.montgomery)
+        result.n = multiply(result.n, mod.r3, mod);
+    return result;
+}
+void invert_batch(DynFinite* data, size_t count) {
+    invert_batch_prefix(data, count);
+}
+
+
+/////////////    ARRAYS    /////////////
+// те же ядра, что у Finite<N>, с константами из текущего модуля
+void add_batch(DynFinite* y, const DynFinite* x, size_t count) {
+    size_t i = 0;
+#ifdef MATRIX_AVX2_KERNELS
+    if (has_avx2())
+        i = add_mod_avx2(reinterpret_cast<uint32_t*>(y), reinterpret_cast<const uint32_t*>(x),
+                         DynFinite::modulus().modulus, count);
+#endif
+    for (; i < count; ++i)
+        y[i] += x[i];
+}
+void sub_batch(DynFinite* y, const DynFinite* x, size_t count) {
+    size_t i = 0;
+#ifdef MATRIX_AVX2_KERNELS
+    if (has_avx2())
+        i = sub_mod_avx2(reinterpret_cast<uint32_t*>(y), reinterpret_cast<const uint32_t*>(x),
+                         DynFinite::modulus().modulus, count);
+#endif
+    for (; i < count; ++i)
+        y[i] -= x[i];
+}
+void mul_batch(DynFinite* y, const DynFinite* x, size_t count) {
+    const FiniteModulus& mod = DynFinite::modulus();
+    size_t i = 0;
+#ifdef MATRIX_AVX2_KERNELS
+    if (mod.montgomery && has_avx2())
+        i = mul_mod_avx2(reinterpret_cast<uint32_t*>(y), reinterpret_cast<const uint32_t*>(x),
+                         mod.modulus, mod.inverse, count);
+#endif
+    for (; i < count; ++i)
+        y[i].n = DynFinite::multiply(y[i].n, x[i].n, mod);
+}
+void scale_batch(DynFinite* y, const DynFinite& a, size_t count) {
+    const FiniteModulus& mod = DynFinite::modulus();
+    size_t i = 0;
+#ifdef MATRIX_AVX2_KERNELS
+    if (mod.montgomery && has_avx2())
+        i = scale_mod_avx2(reinterpret_cast<uint32_t*>(y), a.n, mod.modulus, mod.inverse, count);
+#endif
+    for (; i < count; ++i)
+        y[i].n = DynFinite::multiply(y[i].n, a.n, mod);
+}
+void axpy_batch(DynFinite* y, const DynFinite* x, const DynFinite& a, size_t count) {
+    const FiniteModulus& mod = DynFinite::modulus();
+    size_t i = 0;
+#ifdef MATRIX_AVX2_KERNELS
+    if (mod.montgomery && has_avx2())
+        i = axpy_mod_avx2(reinterpret_cast<uint32_t*>(y), reinterpret_cast<const uint32_t*>(x), a.n,
+                          mod.modulus, mod.inverse, count);
+#endif
+    for (; i < count; ++i) {
+        uint32_t sum = y[i].n + DynFinite::multiply(x[i].n, a.n, mod);
+        y[i].n = std::min(sum, sum - mod.modulus);
+    }
+}
+
+
+/*******************************************************/
+////////////////////   PARALLEL   ///////////////////////
+/*******************************************************/
+
+// Политика выполнения для det, rank, invert и умножения: sequential() считает в текущем
+// потоке, как раньше; parallel(threads) раздаёт строки и блоки пулу потоков
+// (0 — по числу ядер)
+struct Execution {
+    unsigned threads;
+    static Execution sequential();
+    static Execution parallel(unsigned threads = 0);
+};
+
+// Пул с перехватом работы: у каждого потока свой отрезок номеров задач. Хозяин берёт
+// задачи с начала отрезка, а опустевший поток забирает половину с конца чужого, так что
+// неравные по стоимости задачи (строки Rational разной длины) выравниваются сами.
+// Поток, вызвавший run, работает наравне с пулом. Модуль DynFinite этого потока
+// передаётся исполнителям на время задачи
+class WorkStealingPool {
+private:
+    struct Range {
+        std::mutex lock;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+    vector<std::thread> workers;
+    std::unique_ptr<Range[]> ranges;
+    std::mutex submission;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const std::function<void(size_t)>* task = nullptr;
+    const FiniteModulus* context = nullptr;
+    std::exception_ptr failure; // первое исключение из задач текущего run
+    size_t generation = 0;
+    size_t active = 0;
+    bool stopping = false;
+    static thread_local bool inside;
+
+    bool next(size_t slot, size_t& index);
+    void cancel();
+    void work(size_t slot);
+    void loop(size_t slot);
+public:
+    explicit WorkStealingPool(unsigned threads);
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+    ~WorkStealingPool();
+
+    size_t size() const;
+    // task(0), ..., task(count - 1); возвращается, когда все задачи выполнены.
+    // Если задача бросила исключение, оставшиеся не запускаются, а исключение
+    // пробрасывается из run после того, как все исполнители остановились
+    void run(size_t count, const std::function<void(size_t)>& task);
+    // пул на threads потоков, общий для всей программы
+    static WorkStealingPool& shared(unsigned threads);
+};
+
+// Сколько умножений со сложением должно быть в задаче, чтобы её стоило отдавать пулу.
+// Для точных типов хватает одного, для машинных чисел и остатков нужны десятки тысяч;
+// умножение у них режется на блоки tile_rows x tile_columns под упакованные ядра
+template <typename Field>
+struct ParallelGrain {
+    static constexpr bool cheap = std::is_arithmetic<Field>::value;
+    static constexpr size_t operations = cheap ? size_t(1) << 15 : 1;
+    static constexpr size_t tile_rows = cheap ? 128 : 1;
+    static constexpr size_t tile_columns = cheap ? 256 : size_t(-1);
+};
+template <int N>
+struct ParallelGrain<Finite<N>> : ParallelGrain<uint32_t> {};
+template <>
+struct ParallelGrain<DynFinite> : ParallelGrain<uint32_t> {};
+
+
+///////////   CONSTRUCTORS   ///////////
+Execution Execution::sequential() {
+    return Execution{1};
+}
+Execution Execution::parallel(unsigned threads) {
+    if (!threads)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    return Execution{threads};
+}
+
+thread_local bool WorkStealingPool::inside = false;
+
+// вызывающий поток занимает отрезок 0, исполнители — 1..threads-1
+WorkStealingPool::WorkStealingPool(unsigned threads): ranges(new Range[std::max(1u, threads)]) {
+    for (size_t slot = 1; slot < threads; ++slot)
+        workers.emplace_back([this, slot] { loop(slot); });
+}
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers)
+        worker.join();
+}
+size_t WorkStealingPool::size() const {
+    return workers.size() + 1;
+}
+WorkStealingPool& WorkStealingPool::shared(unsigned threads) {
+    static std::mutex pools_lock;
+    static std::map<unsigned, std::unique_ptr<WorkStealingPool>> pools;
+    std::lock_guard<std::mutex> guard(pools_lock);
+    std::unique_ptr<WorkStealingPool>& pool = pools[threads];
+    if (!pool)
+        pool.reset(new WorkStealingPool(threads));
+    return *pool;
+}
+
+/////////////    TASKS    /////////////
+bool WorkStealingPool::next(size_t slot, size_t& index) {
+    {
+        std::lock_guard<std::mutex> guard(ranges[slot].lock);
+        if (ranges[slot].begin < ranges[slot].end) {
+            index = ranges[slot].begin++;
+            return true;
+        }
+    }
+    for (size_t shift = 1; shift < size(); ++shift) {
+        Range& victim = ranges[(slot + shift) % size()];
+        size_t begin, end;
+        {
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if (victim.begin == victim.end)
+                continue;
+            end = victim.end;
+            begin = victim.end -= (victim.end - victim.begin + 1) / 2;
+        }
+        std::lock_guard<std::mutex> guard(ranges[slot].lock);
+        ranges[slot].begin = begin + 1;
+        ranges[slot].end = end;
+        index = begin;
+        return true;
+    }
+    return false;
+}
+// снимает невыданные задачи со всех отрезков
+void WorkStealingPool::cancel() {
+    for (size_t slot = 0; slot < size(); ++slot) {
+        std::lock_guard<std::mutex> guard(ranges[slot].lock);
+        ranges[slot].begin = ranges[slot].end;
+    }
+}
+void WorkStealingPool::work(size_t slot) {
+    size_t index;
+    try {
+        while (next(slot, index))
+            (*task)(index);
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            if (!failure)
+                failure = std::current_exception();
+        }
+        cancel();
+    }
+}
+void WorkStealingPool::loop(size_t slot) {
+    size_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            wake.wait(guard, [&] { return stopping || generation != seen; });
+            if (stopping)
+                return;
+            seen = generation;
+        }
+        const FiniteModulus* previous = DynFinite::context;
+        DynFinite::context = context;
+        inside = true;
+        work(slot);
+        inside = false;
+        DynFinite::context = previous;
+        std::lock_guard<std::mutex> guard(lock);
+        if (--active == 0)
+            done.notify_all();
+    }
+}
+// вложенный вызов из задачи пула выполняется на месте: исполнители уже заняты
+void WorkStealingPool::run(size_t count, const std::function<void(size_t)>& function) {
+    if (inside || workers.empty() || count <= 1) {
+        for (size_t i = 0; i < count; ++i)
+            function(i);
+        return;
+    }
+    std::lock_guard<std::mutex> serial(submission);
+    // task указывает на чужую function и сбрасывается при любом выходе из run
+    struct TaskReset {
+        const std::function<void(size_t)>*& task;
+        ~TaskReset() { task = nullptr; }
+    } reset{task};
+    for (size_t slot = 0; slot < size(); ++slot) {
+        std::lock_guard<std::mutex> guard(ranges[slot].lock);
+        ranges[slot].begin = count * slot / size();
+        ranges[slot].end = count * (slot + 1) / size();
+    }
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        task = &function;
+        context = DynFinite::context;
+        active = workers.size();
+        ++generation;
+    }
+    wake.notify_all();
+    inside = true;
+    work(0);
+    inside = false;
+    std::unique_lock<std::mutex> guard(lock);
+    done.wait(guard, [&] { return active == 0; });
+    std::exception_ptr error = failure;
+    failure = nullptr;
+    if (error)
+        std::rethrow_exception(error);
+}
+
+// function(i) для i из [begin, end): по одному или по нескольку подряд на задачу,
+// чтобы в каждой было не меньше ParallelGrain<Field>::operations операций
+template <typename Field, typename Function>
+void for_each_row(Execution policy, size_t begin, size_t end, size_t length, Function function) {
+    size_t rows = std::max<size_t>(1, (ParallelGrain<Field>::operations + length - 1) / std::max<size_t>(1, length));
+    if (policy.threads <= 1 || end - begin <= rows) {
+        for (size_t i = begin; i < end; ++i)
+            function(i);
+        return;
+    }
+    size_t tasks = (end - begin + rows - 1) / rows;
+    WorkStealingPool::shared(policy.threads).run(tasks, [&](size_t t) {
+        for (size_t i = begin + t * rows; i < std::min(end, begin + (t + 1) * rows); ++i)
+            function(i);
+    });
+}
+
+
+/*******************************************************/
+//////////////////////   GEMM   /////////////////////////
+/*******************************************************/
+
+// C += A * B для таблиц, лежащих по строкам: A — m x k, B — k x n, C — m x n,
+// ldc, lda и ldb — расстояния между началами соседних строк.
+// Общий путь идёт по строкам C: строка — сумма строк B с весами из строки A
+template <typename Field>
+void gemm_rows(Field* c, size_t ldc, const Field* a, size_t lda, const Field* b, size_t ldb,
+               size_t m, size_t k, size_t n) {
+    for (size_t i = 0; i < m; ++i)
+        for (size_t p = 0; p < k; ++p)
+            axpy_batch(c + i * ldc, b + p * ldb, a[i * lda + p], n);
+}
+template <typename Field>
+void gemm(Field* c, size_t ldc, const Field* a, size_t lda, const Field* b, size_t ldb,
+          size_t m, size_t k, size_t n) {
+    gemm_rows(c, ldc, a, lda, b, ldb, m, k, n);
+}
+
+#ifdef MATRIX_AVX2_KERNELS
+// упаковка окупается, когда каждый упакованный элемент используется много раз
+bool worth_packing(size_t m, size_t k, size_t n) {
+    return m >= 32 && k >= 32 && n >= 32;
+}
+
+// Панель A — MR строк, переписанных по столбцам; панель B — NR столбцов, переписанных по строкам.
+// Недостающие строки и столбцы на краю дополняются нулями, чтобы ядро всегда считало целый блок
+template <size_t MR, typename Packed, typename Element>
+void pack_a_panel(Packed* panel, const Element* a, size_t lda, size_t kc, size_t rows) {
+    for (size_t p = 0; p < kc; ++p)
+        for (size_t r = 0; r < MR; ++r)
+            panel[p * MR + r] = r < rows ? Packed(a[r * lda + p]) : Packed(0);
+}
+template <size_t NR, typename Packed, typename Element>
+void pack_b_panel(Packed* panel, const Element* b, size_t ldb, size_t kc, size_t columns) {
+    for (size_t p = 0; p < kc; ++p)
+        for (size_t j = 0; j < NR; ++j)
+            panel[p * NR + j] = j < columns ? Packed(b[p * ldb + j]) : Packed(0);
+}
+
+// панели начинаются с границы строки кэша, чтобы загрузки ядра не пересекали её
+template <typename Packed>
+Packed* cache_aligned(vector<Packed>& buffer) {
+    return reinterpret_cast<Packed*>((reinterpret_cast<uintptr_t>(buffer.data()) + 63) & ~uintptr_t(63));
+}
+
+// Блочное умножение с упаковкой, как в BLIS: полоса B размером KC x NC и блок A размером
+// MC x KC переписываются панелями, которые микроядро читает подряд из L1 и L2;
+// блок результата MR x NR копится в регистрах и добавляется в C один раз за полосу
+template <typename Kernel>
+void gemm_packed(const Kernel& kernel, typename Kernel::Element* c, size_t ldc,
+                 const typename Kernel::Element* a, size_t lda, const typename Kernel::Element* b, size_t ldb,
+                 size_t m, size_t k, size_t n) {
+    using Element = typename Kernel::Element;
+    constexpr size_t MR = Kernel::MR, NR = Kernel::NR, MC = Kernel::MC, KC = Kernel::KC, NC = Kernel::NC;
+    using Packed = typename Kernel::Packed;
+    size_t depth = std::min(k, KC);
+    vector<Packed> buffer_a(depth * ((std::min(m, MC) + MR - 1) / MR * MR) + 64 / sizeof(Packed));
+    vector<Packed> buffer_b(depth * ((std::min(n, NC) + NR - 1) / NR * NR) + 64 / sizeof(Packed));
+    Packed* packed_a = cache_aligned(buffer_a);
+    Packed* packed_b = cache_aligned(buffer_b);
+    Element tile[MR * NR];
+    for (size_t jc = 0; jc < n; jc += NC) {
+        size_t nc = std::min(NC, n - jc);
+        for (size_t pc = 0; pc < k; pc += KC) {
+            size_t kc = std::min(KC, k - pc);
+            for (size_t jr = 0; jr < nc; jr += NR)
+                pack_b_panel<NR>(packed_b + jr * kc, b + pc * ldb + jc + jr, ldb, kc, std::min(NR, nc - jr));
+            for (size_t ic = 0; ic < m; ic += MC) {
+                size_t mc = std::min(MC, m - ic);
+                for (size_t ir = 0; ir < mc; ir += MR)
+                    pack_a_panel<MR>(packed_a + ir * kc, a + (ic + ir) * lda + pc, lda, kc, std::min(MR, mc - ir));
+                for (size_t jr = 0; jr < nc; jr += NR) {
+                    for (size_t ir = 0; ir < mc; ir += MR) {
+                        kernel.multiply(kc, packed_a + ir * kc, packed_b + jr * kc, tile);
+                        Element* target = c + (ic + ir) * ldc + jc + jr;
+                        size_t rows = std::min(MR, mc - ir), columns = std::min(NR, nc - jr);
+                        for (size_t r = 0; r < rows; ++r)
+                            kernel.accumulate(target + r * ldc, tile + r * NR, columns);
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Микроядра. double: блок 6 x 8 — 12 регистров-аккумуляторов по 4 числа, на шаг k
+// две загрузки строки B, шесть рассылок элементов A и 12 FMA. Циклы по строкам блока
+// развёрнуты явно: иначе GCC оставляет массив аккумуляторов в памяти
+struct GemmDouble {
+    using Element = double;
+    using Packed = double;
+    static constexpr size_t MR = 6, NR = 8, MC = 120, KC = 256, NC = 3072;
+    static void multiply(size_t kc, const double* a, const double* b, double* tile);
+    static void accumulate(double* y, const double* x, size_t count);
+};
+__attribute__((target("avx2,fma")))
+void GemmDouble::multiply(size_t kc, const double* a, const double* b, double* tile) {
+    __m256d sum[MR][2];
+    #pragma GCC unroll 8
+    for (size_t r = 0; r < MR; ++r)
+        sum[r][0] = sum[r][1] = _mm256_setzero_pd();
+    for (size_t p = 0; p < kc; ++p, a += MR, b += NR) {
+        __m256d low = _mm256_loadu_pd(b), high = _mm256_loadu_pd(b + 4);
+        #pragma GCC unroll 8
+        for (size_t r = 0; r < MR; ++r) {
+            __m256d factor = _mm256_broadcast_sd(a + r);
+            sum[r][0] = _mm256_fmadd_pd(factor, low, sum[r][0]);
+            sum[r][1] = _mm256_fmadd_pd(factor, high, sum[r][1]);
+        }
+    }
+    #pragma GCC unroll 8
+    for (size_t r = 0; r < MR; ++r) {
+        _mm256_storeu_pd(tile + r * NR, sum[r][0]);
+        _mm256_storeu_pd(tile + r * NR + 4, sum[r][1]);
+    }
+}
+void GemmDouble::accumulate(double* y, const double* x, size_t count) {
+    add_batch(y, x, count);
+}
+
+// float: тот же блок из 12 регистров, но по 8 чисел в каждом — 6 x 16
+struct GemmFloat {
+    using Element = float;
+    using Packed = float;
+    static constexpr size_t MR = 6, NR = 16, MC = 120, KC = 256, NC = 3072;
+    static void multiply(size_t kc, const float* a, const float* b, float* tile);
+    static void accumulate(float* y, const float* x, size_t count);
+};
+__attribute__((target("avx2,fma")))
+void GemmFloat::multiply(size_t kc, const float* a, const float* b, float* tile) {
+    __m256 sum[MR][2];
+    #pragma GCC unroll 8
+    for (size_t r = 0; r < MR; ++r)
+        sum[r][0] = sum[r][1] = _mm256_setzero_ps();
+    for (size_t p = 0; p < kc; ++p, a += MR, b += NR) {
+        __m256 low = _mm256_loadu_ps(b), high = _mm256_loadu_ps(b + 8);
+        #pragma GCC unroll 8
+        for (size_t r = 0; r < MR; ++r) {
+            __m256 factor = _mm256_broadcast_ss(a + r);
+            sum[r][0] = _mm256_fmadd_ps(factor, low, sum[r][0]);
+            sum[r][1] = _mm256_fmadd_ps(factor, high, sum[r][1]);
+        }
+    }
+    #pragma GCC unroll 8
+    for (size_t r = 0; r < MR; ++r) {
+        _mm256_storeu_ps(tile + r * NR, sum[r][0]);
+        _mm256_storeu_ps(tile + r * NR + 8, sum[r][1]);
+    }
+}
+void GemmFloat::accumulate(float* y, const float* x, size_t count) {
+    add_batch(y, x, count);
+}
+
+// Остатки в форме Монтгомери: произведения a * b < N^2 складываются в 64-битных дорожках
+// без редукции. Когда сумма может переполниться, старшая половина сворачивается:
+// hi * 2^32 + lo ≡ hi * (2^32 mod N) + lo, после чего сумма меньше N * 2^32.
+// В конце одна редукция Монтгомери на элемент: sum(aR * bR) * R^(-1) = sum(ab) * R.
+// Элементы панелей расширены до 64 бит, чтобы _mm256_mul_epu32 брал их без сдвигов
+struct GemmModular {
+    using Element = uint32_t;
+    using Packed = uint64_t;
+    static constexpr size_t MR = 4, NR = 8, MC = 128, KC = 256, NC = 3072;
+    uint32_t modulus;
+    uint32_t inverse;
+    uint32_t fold;
+    size_t period;
+    GemmModular(uint32_t modulus, uint32_t inverse);
+    void multiply(size_t kc, const uint64_t* a, const uint64_t* b, uint32_t* tile) const;
+    void accumulate(uint32_t* y, const uint32_t* x, size_t count) const;
+};
+// period — сколько произведений (N - 1)^2 помещается в 2^64 поверх свёрнутой суммы < 2^32 * N
+GemmModular::GemmModular(uint32_t modulus, uint32_t inverse)
+    : modulus(modulus), inverse(inverse), fold((uint64_t(1) << 32) % modulus),
+      period(modulus == 1 ? size_t(-1)
+             : (~uint64_t(0) - (uint64_t(1) << 32) * modulus) / (uint64_t(modulus - 1) * (modulus - 1))) {}
+
+__attribute__((target("avx2")))
+static inline __m256i fold_avx2(__m256i sum, __m256i fold, __m256i low) {
+    return _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(sum, 32), fold), _mm256_and_si256(sum, low));
+}
+__attribute__((target("avx2")))
+void GemmModular::multiply(size_t kc, const uint64_t* a, const uint64_t* b, uint32_t* tile) const {
+    const __m256i low = _mm256_set1_epi64x(0xFFFFFFFF);
+    const __m256i folding = _mm256_set1_epi64x(fold);
+    __m256i sum[MR][2];
+    #pragma GCC unroll 8
+    for (size_t r = 0; r < MR; ++r)
+        sum[r][0] = sum[r][1] = _mm256_setzero_si256();
+    for (size_t p = 0; p < kc;) {
+        size_t end = p + std::min(kc - p, period);
+        for (; p < end; ++p, a += MR, b += NR) {
+            __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+            __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + 4));
+            #pragma GCC unroll 8
+            for (size_t r = 0; r < MR; ++r) {
+                __m256i factor = _mm256_set1_epi64x(a[r]);
+                sum[r][0] = _mm256_add_epi64(sum[r][0], _mm256_mul_epu32(factor, first));
+                sum[r][1] = _mm256_add_epi64(sum[r][1], _mm256_mul_epu32(factor, second));
+            }
+        }
+        #pragma GCC unroll 8
+        for (size_t r = 0; r < MR; ++r) {
+            sum[r][0] = fold_avx2(sum[r][0], folding, low);
+            sum[r][1] = fold_avx2(sum[r][1], folding, low);
+        }
+    }
+    // редукция в 64-битных дорожках; столбцы 0-3 и 4-7 сливаются в один регистр
+    // через чередование, которое затем переставляется обратно по порядку
+    const __m256i mod = _mm256_set1_epi64x(modulus);
+    const __m256i inv = _mm256_set1_epi64x(inverse);
+    const __m256i order = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    #pragma GCC unroll 8
+    for (size_t r = 0; r < MR; ++r) {
+        __m256i reduced[2];
+        #pragma GCC unroll 8
+        for (size_t h = 0; h < 2; ++h) {
+            __m256i m = _mm256_mul_epu32(sum[r][h], inv);
+            reduced[h] = _mm256_srli_epi64(_mm256_add_epi64(sum[r][h], _mm256_mul_epu32(m, mod)), 32);
+        }
+        __m256i t = _mm256_blend_epi32(reduced[0], _mm256_slli_epi64(reduced[1], 32), 0xAA);
+        t = _mm256_permutevar8x32_epi32(t, order);
+        t = _mm256_min_epu32(t, _mm256_sub_epi32(t, _mm256_set1_epi32(modulus)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(tile + r * NR), t);
+    }
+}
+void GemmModular::accumulate(uint32_t* y, const uint32_t* x, size_t count) const {
+    size_t i = add_mod_avx2(y, x, modulus, count);
+    for (; i < count; ++i) {
+        uint32_t sum = y[i] + x[i];
+        y[i] = std::min(sum, sum - modulus);
+    }
+}
+#endif
+
+void gemm(double* c, size_t ldc, const double* a, size_t lda, const double* b, size_t ldb,
+          size_t m, size_t k, size_t n) {
+#ifdef MATRIX_AVX2_KERNELS
+    if (worth_packing(m, k, n) && has_avx2() && has_fma())
+        return gemm_packed(GemmDouble(), c, ldc, a, lda, b, ldb, m, k, n);
+#endif
+    gemm_rows(c, ldc, a, lda, b, ldb, m, k, n);
+}
+void gemm(float* c, size_t ldc, const float* a, size_t lda, const float* b, size_t ldb,
+          size_t m, size_t k, size_t n) {
+#ifdef MATRIX_AVX2_KERNELS
+    if (worth_packing(m, k, n) && has_avx2() && has_fma())
+        return gemm_packed(GemmFloat(), c, ldc, a, lda, b, ldb, m, k, n);
+#endif
+    gemm_rows(c, ldc, a, lda, b, ldb, m, k, n);
+}
+// чётный модуль хранится без формы Монтгомери и идёт общим путём
+template <int N>
+void gemm(Finite<N>* c, size_t ldc, const Finite<N>* a, size_t lda, const Finite<N>* b, size_t ldb,
+          size_t m, size_t k, size_t n) {
+#ifdef MATRIX_AVX2_KERNELS
+    if (Finite<N>::montgomery && worth_packing(m, k, n) && has_avx2())
+        return gemm_packed(GemmModular(Finite<N>::modulus, Finite<N>::inverse),
+                           reinterpret_cast<uint32_t*>(c), ldc, reinterpret_cast<const uint32_t*>(a), lda,
+                           reinterpret_cast<const uint32_t*>(b), ldb, m, k, n);
+#endif
+    gemm_rows(c, ldc, a, lda, b, ldb, m, k, n);
+}
+void gemm(DynFinite* c, size_t ldc, const DynFinite* a, size_t lda, const DynFinite* b, size_t ldb,
+          size_t m, size_t k, size_t n) {
+#ifdef MATRIX_AVX2_KERNELS
+    const FiniteModulus& mod = DynFinite::modulus();
+    if (mod.montgomery && mod.modulus < (1u << 31) && worth_packing(m, k, n) && has_avx2())
+        return gemm_packed(GemmModular(mod.modulus, mod.inverse),
+                           reinterpret_cast<uint32_t*>(c), ldc, reinterpret_cast<const uint32_t*>(a), lda,
+                           reinterpret_cast<const uint32_t*>(b), ldb, m, k, n);
+#endif
+    gemm_rows(c, ldc, a, lda, b, ldb, m, k, n);
+}
+
+// C делится на независимые блоки, и каждый считается своим вызовом gemm
+template <typename Field>
+void gemm(Field* c, size_t ldc, const Field* a, size_t lda, const Field* b, size_t ldb,
+          size_t m, size_t k, size_t n, Execution policy) {
+    size_t tile_rows = ParallelGrain<Field>::tile_rows;
+    size_t tile_columns = std::min(n, ParallelGrain<Field>::tile_columns);
+    size_t row_tiles = (m + tile_rows - 1) / tile_rows, column_tiles = (n + tile_columns - 1) / tile_columns;
+    if (policy.threads <= 1 || row_tiles * column_tiles <= 1 || m * k * n < ParallelGrain<Field>::operations)
+        return gemm(c, ldc, a, lda, b, ldb, m, k, n);
+    WorkStealingPool::shared(policy.threads).run(row_tiles * column_tiles, [&](size_t t) {
+        size_t i = t / column_tiles * tile_rows, j = t % column_tiles * tile_columns;
+        gemm(c + i * ldc + j, ldc, a + i * lda, lda, b + j, ldb,
+             std::min(tile_rows, m - i), k, std::min(tile_columns, n - j));
+    });
+}
+
+
+/*******************************************************/
+////////////////////   STRASSEN   ///////////////////////
+/*******************************************************/
+
+// Винограду нужно 7 умножений половинных блоков вместо 8 ценой 15 сложений блоков.
+// Рекурсия идёт, пока все размеры не меньше size: у длинных чисел окупается почти сразу,
+// у вычетов — только на больших таблицах поверх упакованного ядра.
+// Плавающую точку не трогаем: разности блоков теряют точность
+template <typename Field>
+struct StrassenCutoff {
+    static constexpr size_t size = std::is_arithmetic<Field>::value ? size_t(-1) : 32;
+};
+template <int N>
+struct StrassenCutoff<Finite<N>> {
+    static constexpr size_t size = 256;
+};
+template <>
+struct StrassenCutoff<DynFinite> : StrassenCutoff<Finite<3>> {};
+
+// Y = A + B, Y = A - B, Y += X и Y -= X для блоков rows x columns
+template <typename Field>
+void block_sum(Field* y, size_t ldy, const Field* a, size_t lda, const Field* b, size_t ldb,
+               size_t rows, size_t columns) {
+    for (size_t i = 0; i < rows; ++i) {
+        std::copy(a + i * lda, a + i * lda + columns, y + i * ldy);
+        add_batch(y + i * ldy, b + i * ldb, columns);
+    }
+}
+template <typename Field>
+void block_difference(Field* y, size_t ldy, const Field* a, size_t lda, const Field* b, size_t ldb,
+                      size_t rows, size_t columns) {
+    for (size_t i = 0; i < rows; ++i) {
+        std::copy(a + i * lda, a + i * lda + columns, y + i * ldy);
+        sub_batch(y + i * ldy, b + i * ldb, columns);
+    }
+}
+template <typename Field>
+void block_add(Field* y, size_t ldy, const Field* x, size_t ldx, size_t rows, size_t columns) {
+    for (size_t i = 0; i < rows; ++i)
+        add_batch(y + i * ldy, x + i * ldx, columns);
+}
+template <typename Field>
+void block_subtract(Field* y, size_t ldy, const Field* x, size_t ldx, size_t rows, size_t columns) {
+    for (size_t i = 0; i < rows; ++i)
+        sub_batch(y + i * ldy, x + i * ldx, columns);
+}
+
+// C += A * B. Рекурсия идёт по чётной части размеров, а нечётный остаток —
+// последнее слагаемое по k, последний столбец и последняя строка C — досчитывает gemm.
+// Знаки S2, S4 и T1 обращены, чтобы все разности считались на месте
+template <typename Field>
+void strassen(Field* c, size_t ldc, const Field* a, size_t lda, const Field* b, size_t ldb,
+              size_t m, size_t k, size_t n, Execution policy) {
+    if (std::min({m, k, n}) < StrassenCutoff<Field>::size)
+        return gemm(c, ldc, a, lda, b, ldb, m, k, n, policy);
+    size_t hm = m / 2, hk = k / 2, hn = n / 2;
+    const Field *a11 = a, *a12 = a + hk, *a21 = a + hm * lda, *a22 = a21 + hk;
+    const Field *b11 = b, *b12 = b + hn, *b21 = b + hk * ldb, *b22 = b21 + hn;
+    Field *c11 = c, *c12 = c + hn, *c21 = c + hm * ldc, *c22 = c21 + hn;
+    vector<Field> x(hm * hk), y(hk * hn), p(hm * hn), q(hm * hn, Field(0));
+
+    // Q = P1 = A11 B11;  C11 += P1 + A12 B21
+    strassen(q.data(), hn, a11, lda, b11, ldb, hm, hk, hn, policy);
+    block_add(c11, ldc, q.data(), hn, hm, hn);
+    strassen(c11, ldc, a12, lda, b21, ldb, hm, hk, hn, policy);
+    // X = S1 = A21 + A22, Y = -T1 = B11 - B12;  C12 -= S1 Y, C22 -= S1 Y
+    block_sum(x.data(), hk, a21, lda, a22, lda, hm, hk);
+    block_difference(y.data(), hn, b11, ldb, b12, ldb, hk, hn);
+    std::fill(p.begin(), p.end(), Field(0));
+    strassen(p.data(), hn, x.data(), hk, y.data(), hn, hm, hk, hn, policy);
+    block_subtract(c12, ldc, p.data(), hn, hm, hn);
+    block_subtract(c22, ldc, p.data(), hn, hm, hn);
+    // X = S2 = S1 - A11, Y = T2 = B22 + Y;  Q = U2 = P1 + S2 T2;  C12 += U2
+    block_subtract(x.data(), hk, a11, lda, hm, hk);
+    block_add(y.data(), hn, b22, ldb, hk, hn);
+    strassen(q.data(), hn, x.data(), hk, y.data(), hn, hm, hk, hn, policy);
+    block_add(c12, ldc, q.data(), hn, hm, hn);
+    // X = -S4 = S2 - A12;  C12 -= X B22
+    block_subtract(x.data(), hk, a12, lda, hm, hk);
+    std::fill(p.begin(), p.end(), Field(0));
+    strassen(p.data(), hn, x.data(), hk, b22, ldb, hm, hk, hn, policy);
+    block_subtract(c12, ldc, p.data(), hn, hm, hn);
+    // Y = T4 = T2 - B21;  C21 -= A22 T4
+    block_subtract(y.data(), hn, b21, ldb, hk, hn);
+    std::fill(p.begin(), p.end(), Field(0));
+    strassen(p.data(), hn, a22, lda, y.data(), hn, hm, hk, hn, policy);
+    block_subtract(c21, ldc, p.data(), hn, hm, hn);
+    // X = S3 = A11 - A21, Y = T3 = B22 - B12;  Q = U3 = U2 + S3 T3;  C21 += U3, C22 += U3
+    block_difference(x.data(), hk, a11, lda, a21, lda, hm, hk);
+    block_difference(y.data(), hn, b22, ldb, b12, ldb, hk, hn);
+    strassen(q.data(), hn, x.data(), hk, y.data(), hn, hm, hk, hn, policy);
+    block_add(c21, ldc, q.data(), hn, hm, hn);
+    block_add(c22, ldc, q.data(), hn, hm, hn);
+
+    if (k % 2)
+        gemm(c, ldc, a + 2 * hk, lda, b + 2 * hk * ldb, ldb, 2 * hm, 1, 2 * hn, policy);
+    if (n % 2)
+        gemm(c + 2 * hn, ldc, a, lda, b + 2 * hn, ldb, 2 * hm, k, 1, policy);
+    if (m % 2)
+        gemm(c + 2 * hm * ldc, ldc, a + 2 * hm * lda, lda, b, ldb, 1, k, n, policy);
+}
+
+// Суммы дробей с разными знаменателями дорожают быстрее, чем экономятся умножения,
+// поэтому Rational идёт по Винограду, только если все записи целые
+template <typename Field>
+bool strassen_pays(const Field*, size_t, size_t, size_t) {
+    return true;
+}
+bool strassen_pays(const Rational* table, size_t ld, size_t rows, size_t columns) {
+    for (size_t i = 0; i < rows; ++i)
+        for (size_t j = 0; j < columns; ++j)
+            if (table[i * ld + j].getDenominator() != 1)
+                return false;
+    return true;
+}
+// C += A * B с выбором между Виноградом и gemm
+template <typename Field>
+void multiply_table(Field* c, size_t ldc, const Field* a, size_t lda, const Field* b, size_t ldb,
+                    size_t m, size_t k, size_t n, Execution policy) {
+    if (std::min({m, k, n}) >= StrassenCutoff<Field>::size && strassen_pays(a, lda, m, k) && strassen_pays(b, ldb, k, n))
+        return strassen(c, ldc, a, lda, b, ldb, m, k, n, policy);
+    gemm(c, ldc, a, lda, b, ldb, m, k, n, policy);
+}
+
+
+/*******************************************************/
+/////////////////////   POWER   /////////////////////////
+/*******************************************************/
+
+// Матрица-компаньон рекуррентности f(n + k) = c_1 f(n + k - 1) + ... + c_k f(n):
+// первая строка c_1 ... c_k, под диагональю единицы, остальное нули. Её транспонированная —
+// умножение на x в Field[x] / (x^k - c_1 x^{k-1} - ... - c_k) в базисе x^{k-1}, ..., 1,
+// поэтому строка i степени e — коэффициенты x^{e+k-1-i} по этому модулю от старших к младшим
+// (метод Китамасы): O(k^2 log e) вместо O(k^3 log e) при возведении матрицы.
+// reduction[i] — коэффициент при x^i у остатка x^k, многочлены хранятся от младших
+
+// p = p * q mod; product — рабочий буфер на 2k - 1 элементов
+template <typename Field>
+void multiply_mod(vector<Field>& p, const vector<Field>& q, const vector<Field>& reduction,
+                  vector<Field>& product) {
+    size_t k = reduction.size();
+    std::fill(product.begin(), product.end(), Field(0));
+    for (size_t i = 0; i < k; ++i)
+        axpy_batch(product.data() + i, q.data(), p[i], k);
+    for (size_t d = 2 * k - 2; d >= k; --d)
+        axpy_batch(product.data() + d - k, reduction.data(), product[d], k);
+    std::copy(product.begin(), product.begin() + k, p.begin());
+}
+// p = x * p mod
+template <typename Field>
+void shift_mod(vector<Field>& p, const vector<Field>& reduction) {
+    Field top = p.back();
+    std::copy_backward(p.begin(), p.end() - 1, p.end());
+    p[0] = Field(0);
+    axpy_batch(p.data(), reduction.data(), top, p.size());
+}
+// result — степень exponent матрицы-компаньона с первой строкой coefficients
+template <typename Field>
+void kitamasa_power(Field* result, const Field* coefficients, size_t k, uint64_t exponent) {
+    vector<Field> reduction(coefficients, coefficients + k), power(k, Field(0)), product(2 * k - 1);
+    std::reverse(reduction.begin(), reduction.end());
+    power[0] = Field(1);
+    for (int bit = 63; bit >= 0; --bit) {
+        if (exponent >> bit == 0)
+            continue;
+        multiply_mod(power, power, reduction, product);
+        if (exponent >> bit & 1)
+            shift_mod(power, reduction);
+    }
+    for (size_t i = k; i-- > 0;) {
+        std::reverse_copy(power.begin(), power.end(), result + i * k);
+        if (i)
+            shift_mod(power, reduction);
+    }
+}
+// первая строка произвольна, строка i > 0 — единица в столбце i - 1
+template <typename Field>
+bool is_companion(const Field* table, size_t k) {
+    for (size_t i = 1; i < k; ++i)
+        for (size_t j = 0; j < k; ++j)
+            if (!(table[i * k + j] == Field(j + 1 == i ? 1 : 0)))
+                return false;
+    return true;
+}
+// Степень матрицы-компаньона, в том числе записанной в обратном порядке
+// (единицы над диагональю, коэффициенты в последней строке); false — матрица не такая
+template <typename Field>
+bool companion_power(Field* result, const Field* table, size_t k, uint64_t exponent) {
+    if (is_companion(table, k)) {
+        kitamasa_power(result, table, k, exponent);
+        return true;
+    }
+    vector<Field> reversed(table, table + k * k);
+    std::reverse(reversed.begin(), reversed.end());
+    if (!is_companion(reversed.data(), k))
+        return false;
+    kitamasa_power(result, reversed.data(), k, exponent);
+    std::reverse(result, result + k * k);
+    return true;
+}
+
+/*******************************************************/
+///////////////////   ELIMINATION   /////////////////////
+/*******************************************************/
+
+// Метод Гаусса на таблице, лежащей по строкам; таблица портится.
+// Строки под ведущей обновляются независимо и делятся между потоками
+template <typename Field>
+Field det_table(Field* table, size_t n, Execution policy) {
+    Field det = 1;
+    for (size_t i = 0; i < n; ++i) {
+        Field* top = table + i * n;
+        size_t this_row = i;
+        while (this_row < n && !table[this_row * n + i])
+            ++this_row;
+        if (this_row == n)
+            return 0;
+        if (this_row != i) {
+            std::swap_ranges(top, top + n, table + this_row * n);
+            det = -det;
+        }
+        det *= top[i];
+        Field inverse = Field(1) / top[i];
+        for_each_row<Field>(policy, i + 1, n, n - i, [&](size_t j) {
+            Field k = -(table[j * n + i] * inverse);
+            axpy_batch(table + j * n + i, top + i, k, n - i);
+        });
+    }
+    return det;
+}
+// ступенчатый вид: столбец без ведущего элемента пропускается, а строка остаётся
+// кандидатом для следующих столбцов
+template <typename Field>
+size_t rank_table(Field* table, size_t rows, size_t columns, Execution policy) {
+    size_t rank = 0;
+    for (size_t i = 0; i < columns && rank < rows; ++i) {
+        size_t this_row = rank;
+        while (this_row < rows && !table[this_row * columns + i])
+            ++this_row;
+        if (this_row == rows)
+            continue;
+        Field* top = table + rank * columns;
+        if (this_row != rank)
+            std::swap_ranges(top, top + columns, table + this_row * columns);
+        Field inverse = Field(1) / top[i];
+        for_each_row<Field>(policy, rank + 1, rows, columns - i, [&](size_t j) {
+            Field k = -(table[j * columns + i] * inverse);
+            axpy_batch(table + j * columns + i, top + i, k, columns - i);
+        });
+        ++rank;
+    }
+    return rank;
+}
+
+// Метод Бареиса для целых матриц: после шага k элемент (i, j) равен минору из первых
+// k строк и столбцов с добавленными строкой i и столбцом j, поэтому деление на
+// предыдущий ведущий элемент всегда точное, и числа растут линейно, а не экспоненциально.
+// Integer — BigInteger или целый тип вроде FixedInt<Bits>, у которого деление
+// отбрасывает дробную часть: Гаусс с делением на ведущий элемент для него неверен
+template <typename Integer>
+Integer bareiss_det(vector<Integer> table, size_t n, Execution policy) {
+    Integer previous = 1;
+    bool negative = false;
+    for (size_t k = 0; k < n; ++k) {
+        Integer* top = table.data() + k * n;
+        size_t this_row = k;
+        while (this_row < n && table[this_row * n + k] == 0)
+            ++this_row;
+        if (this_row == n)
+            return 0;
+        if (this_row != k) {
+            std::swap_ranges(top, top + n, table.data() + this_row * n);
+            negative = !negative;
+        }
+        for_each_row<Integer>(policy, k + 1, n, n - k, [&](size_t i) {
+            Integer* row = table.data() + i * n;
+            for (size_t j = k + 1; j < n; ++j) {
+                row[j] *= top[k];
+                row[j] -= row[k] * top[j];
+                row[j] /= previous;
+            }
+        });
+        previous = top[k];
+    }
+    return negative ? -previous : previous;
+}
+// то же до ступенчатого вида: столбец без ведущего элемента пропускается, деления остаются
+// точными, потому что элементы — миноры по выбранным ведущим столбцам
+template <typename Integer>
+size_t bareiss_rank(vector<Integer> table, size_t rows, size_t columns, Execution policy) {
+    Integer previous = 1;
+    size_t rank = 0;
+    for (size_t k = 0; k < columns && rank < rows; ++k) {
+        size_t this_row = rank;
+        while (this_row < rows && table[this_row * columns + k] == 0)
+            ++this_row;
+        if (this_row == rows)
+            continue;
+        Integer* top = table.data() + rank * columns;
+        if (this_row != rank)
+            std::swap_ranges(top, top + columns, table.data() + this_row * columns);
+        for_each_row<Integer>(policy, rank + 1, rows, columns - k, [&](size_t i) {
+            Integer* row = table.data() + i * columns;
+            for (size_t j = k + 1; j < columns; ++j) {
+                row[j] *= top[k];
+                row[j] -= row[k] * top[j];
+                row[j] /= previous;
+            }
+        });
+        previous = top[k];
+        ++rank;
+    }
+    return rank;
+}
+// Простые меньше 2^31 по убыванию: остатки по ним — DynFinite с теми же ядрами, что у Finite<P>.
+// Найденные простые запоминаются для следующих вызовов
+vector<uint32_t> crt_primes(size_t count) {
+    static std::mutex lock;
+    static vector<uint32_t> primes;
+    std::lock_guard<std::mutex> guard(lock);
+    uint32_t candidate = primes.empty() ? (1u << 31) - 1 : primes.back() - 2;
+    for (; primes.size() < count; candidate -= 2) {
+        bool prime = true;
+        for (uint32_t d = 3; d * d <= candidate && prime; d += 2)
+            prime = candidate % d != 0;
+        if (prime)
+            primes.push_back(candidate);
+    }
+    return vector<uint32_t>(primes.begin(), primes.begin() + count);
+}
+// log2 оценки Адамара prod ||row_i|| по ненулевым строкам, где |a| < 10^length(a).
+// Она ограничивает модуль любого минора: у ненулевой целой строки норма не меньше 1
+double hadamard_bits(const vector<BigInteger>& table, size_t rows, size_t columns) {
+    double bits = 0;
+    for (size_t i = 0; i < rows; ++i) {
+        const BigInteger* row = table.data() + i * columns;
+        size_t longest = 0;
+        for (size_t j = 0; j < columns; ++j)
+            if (row[j] != 0)
+                longest = max(longest, row[j].length());
+        if (!longest)
+            continue;
+        double squares = 0;
+        for (size_t j = 0; j < columns; ++j)
+            if (row[j] != 0)
+                squares += std::pow(100.0, double(row[j].length()) - double(longest));
+        bits += (longest + 0.5 * std::log10(squares)) * std::log2(10.0);
+    }
+    return bits;
+}
+// остатки таблицы по модулю текущего DynFinite::Scope
+vector<DynFinite> reduce_table(const vector<BigInteger>& table, uint32_t prime) {
+    vector<DynFinite> reduced(table.size());
+    for (size_t i = 0; i < table.size(); ++i)
+        reduced[i] = DynFinite(int(table[i].remainder(prime)));
+    return reduced;
+}
+// Число по остаткам: коэффициенты смешанной системы счисления x = c0 + c1 p0 + c2 p0 p1 + ...
+// (алгоритм Гарнера) считаются в DynFinite, а само число собирается схемой Горнера.
+// Результат приводится к отрезку (-P/2, P/2], P = p0 p1 ...
+BigInteger crt_reconstruct(const vector<uint32_t>& residues, const vector<uint32_t>& primes) {
+    vector<uint32_t> coefficients(primes.size());
+    for (size_t i = 0; i < primes.size(); ++i) {
+        FiniteModulus mod(primes[i]);
+        DynFinite::Scope scope(mod);
+        DynFinite value = 0, product = 1;
+        for (size_t j = 0; j < i; ++j) {
+            value += DynFinite(int(coefficients[j])) * product;
+            product *= DynFinite(int(primes[j]));
+        }
+        coefficients[i] = int((DynFinite(int(residues[i])) - value) / product);
+    }
+    BigInteger result = 0, modulus = 1;
+    for (size_t i = primes.size(); i-- > 0;) {
+        result *= BigInteger(int(primes[i]));
+        result += BigInteger(int(coefficients[i]));
+        modulus *= BigInteger(int(primes[i]));
+    }
+    if (modulus < result + result)
+        result -= modulus;
+    return result;
+}
+// Детерминант по стольким простым, чтобы их произведение превысило удвоенную оценку
+// Адамара; каждый остаток — обычный Гаусс над DynFinite, простые делятся между потоками
+BigInteger modular_det(const vector<BigInteger>& table, size_t n, Execution policy) {
+    double bits = hadamard_bits(table, n, n) + 1;
+    vector<uint32_t> primes = crt_primes(size_t(bits / 30) + 1);
+    double covered = 0;
+    size_t count = 0;
+    while (covered <= bits)
+        covered += std::log2(double(primes[count++]));
+    primes.resize(count);
+    vector<uint32_t> residues(count);
+    for_each_row<BigInteger>(policy, 0, count, 1, [&](size_t t) {
+        FiniteModulus mod(primes[t]);
+        DynFinite::Scope scope(mod);
+        vector<DynFinite> reduced = reduce_table(table, primes[t]);
+        residues[t] = int(det_table(reduced.data(), n, Execution::sequential()));
+    });
+    return crt_reconstruct(residues, primes);
+}
+// Ранг по простому модулю не больше ранга над Q и меньше него, только если модуль делит
+// все ненулевые миноры наибольшего порядка. Полный ранг доказан первым же простым.
+// Неполный ранг принимается, когда rank_agreement простых подряд дают один и тот же ранг:
+// ошибка возможна, только если их произведение (больше 2^90) делит все такие миноры.
+// Раньше остановиться может оценка Адамара: простые с произведением больше неё дают точный ответ
+const size_t rank_agreement = 3;
+size_t modular_rank(const vector<BigInteger>& table, size_t rows, size_t columns, Execution policy) {
+    double bits = hadamard_bits(table, rows, columns);
+    size_t full = std::min(rows, columns), rank = 0, agreeing = 0;
+    double covered = 0;
+    for (size_t count = 1; covered <= bits && rank < full && agreeing < rank_agreement; ++count) {
+        uint32_t prime = crt_primes(count).back();
+        FiniteModulus mod(prime);
+        DynFinite::Scope scope(mod);
+        vector<DynFinite> reduced = reduce_table(table, prime);
+        size_t current = rank_table(reduced.data(), rows, columns, policy);
+        if (current > rank) {
+            rank = current;
+            agreeing = 1;
+        } else if (current == rank) {
+            ++agreeing;
+        }
+        covered += std::log2(double(prime));
+    }
+    return rank;
+}
+
+// Целочисленные матрицы считаются без дробей: это элементы BigInteger, Rational
+// со знаменателем 1 и целые типы с std::numeric_limits<Field>::is_integer (FixedInt<Bits>),
+// которые идут через Бареиса. Для остальных типов таких путей нет, и функции возвращают false
+template <typename Field>
+bool integer_det(const Field* table, size_t n, Execution policy, Field& det) {
+    if constexpr (std::numeric_limits<Field>::is_integer) {
+        det = bareiss_det(vector<Field>(table, table + n * n), n, policy);
+        return true;
+    }
+    return false;
+}
+template <typename Field>
+bool integer_rank(const Field* table, size_t rows, size_t columns, Execution policy, size_t& rank) {
+    if constexpr (std::numeric_limits<Field>::is_integer) {
+        rank = bareiss_rank(vector<Field>(table, table + rows * columns), rows, columns, policy);
+        return true;
+    }
+    return false;
+}
+bool integer_entries(const Rational* table, size_t count, vector<BigInteger>& integers) {
+    for (size_t i = 0; i < count; ++i)
+        if (table[i].getDenominator() != 1)
+            return false;
+    integers.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+        integers.push_back(table[i].getNumerator());
+    return true;
+}
+// BigInteger и Rational идут только через простые модули, без Бареиса: точное деление
+// этой длинной арифметики подбирает каждый разряд двоичным поиском, и уже при n = 3
+// Бареис в 3–4 раза медленнее, при n = 8 — в 30–100 раз
+bool integer_det(const BigInteger* table, size_t n, Execution policy, BigInteger& det) {
+    det = modular_det(vector<BigInteger>(table, table + n * n), n, policy);
+    return true;
+}
+bool integer_det(const Rational* table, size_t n, Execution policy, Rational& det) {
+    vector<BigInteger> integers;
+    if (!integer_entries(table, n * n, integers))
+        return false;
+    det = Rational(modular_det(integers, n, policy), 1);
+    return true;
+}
+bool integer_rank(const BigInteger* table, size_t rows, size_t columns, Execution policy, size_t& rank) {
+    rank = modular_rank(vector<BigInteger>(table, table + rows * columns), rows, columns, policy);
+    return true;
+}
+bool integer_rank(const Rational* table, size_t rows, size_t columns, Execution policy, size_t& rank) {
+    vector<BigInteger> integers;
+    if (!integer_entries(table, rows * columns, integers))
+        return false;
+    rank = modular_rank(integers, rows, columns, policy);
+    return true;
 }
 
 
@@ -933,18 +2581,26 @@ Finite<N> Finite<N>::get_opposite() const {
 /////////////////////   MATRIX   ////////////////////////
 /*******************************************************/
 
+// Элементы лежат по строкам в одном буфере: маленькие матрицы (до 16 элементов) —
+// прямо в объекте, остальные — в одном vector. operator[] отдаёт указатель на строку
 template <unsigned M, unsigned N, typename Field = Rational>
 class Matrix {
 private:
-    vector<vector<Field>> table;
+    static constexpr bool is_inline = size_t(M) * N <= 16;
+    using Storage = typename std::conditional<is_inline, std::array<Field, size_t(M) * N>, vector<Field>>::type;
+    Storage table;
+    static void allocate(vector<Field>&);
+    static void allocate(std::array<Field, size_t(M) * N>&);
+    Field* row(size_t);
+    const Field* row(size_t) const;
 public:
     Matrix();
     Matrix(const vector<vector<Field>>&);
     Matrix(const vector<vector<int>>&);
     ~Matrix() = default;
 
-    vector<Field>& operator[](size_t);
-    const vector<Field>& operator[](size_t) const;
+    Field* operator[](size_t);
+    const Field* operator[](size_t) const;
     vector<Field> getRow(unsigned index);
     vector<Field> getColumn(unsigned index);
 
@@ -954,11 +2610,12 @@ public:
     Matrix<M, N, Field>& operator*=(const Matrix<M, N, Field> &);
 
     Matrix<N, M, Field> transposed() const;
-    Matrix<M, N, Field> inverted() const;
-    Matrix<M, N, Field>& invert();
-    size_t rank() const;
+    Matrix<M, N, Field> inverted(Execution policy = Execution::sequential()) const;
+    Matrix<M, N, Field>& invert(Execution policy = Execution::sequential());
+    size_t rank(Execution policy = Execution::sequential()) const;
     Field trace() const;
-    Field det() const;
+    Field det(Execution policy = Execution::sequential()) const;
+    Matrix<M, N, Field> pow(uint64_t exponent, Execution policy = Execution::sequential()) const;
 
     void swapRows(size_t i, size_t j);
     void swapColumns (size_t i, size_t j);
@@ -967,50 +2624,65 @@ public:
 
 ///////////   CONSTRUCTORS   ///////////
 template<unsigned int M, unsigned int N, typename Field>
+void Matrix<M, N, Field>::allocate(vector<Field>& storage) {
+    storage.assign(size_t(M) * N, Field(0));
+}
+template<unsigned int M, unsigned int N, typename Field>
+void Matrix<M, N, Field>::allocate(std::array<Field, size_t(M) * N>& storage) {
+    storage.fill(Field(0));
+}
+template<unsigned int M, unsigned int N, typename Field>
 Matrix<M, N, Field>::Matrix() {
-    table.assign(M, vector<Field>(N, 0));
+    allocate(table);
     if (M == N) {
         size_t i = 0;
         while (i < M) {
-            table[i][i] = 1;
+            row(i)[i] = 1;
             ++i;
         }
     }
 }
 template<unsigned int M, unsigned int N, typename Field>
 Matrix<M, N, Field>::Matrix(const vector<vector<Field>>& v) {
-    table = v;
+    allocate(table);
+    for (size_t i = 0; i < M; ++i)
+        std::copy(v[i].begin(), v[i].begin() + N, row(i));
 }
 template<unsigned int M, unsigned int N, typename Field>
 Matrix<M, N, Field>::Matrix(const vector<vector<int>>& v) {
-    for (size_t i = 0; i < M; ++i) {
-        vector<Field> tmp;
-        for (size_t j = 0; j < N; ++j) {
-            tmp.push_back(v[i][j]);
-        }
-        table.push_back(tmp);
-    }
-
+    allocate(table);
+    for (size_t i = 0; i < M; ++i)
+        for (size_t j = 0; j < N; ++j)
+            row(i)[j] = v[i][j];
 }
 
 ///////////    GET ELEMENT    ///////////
 template<unsigned int M, unsigned int N, typename Field>
-vector<Field>& Matrix<M, N, Field>::operator[](size_t pos) {
-    return table[pos];
+Field* Matrix<M, N, Field>::row(size_t pos) {
+    return table.data() + pos * N;
+}
+template<unsigned int M, unsigned int N, typename Field>
+const Field* Matrix<M, N, Field>::row(size_t pos) const {
+    return table.data() + pos * N;
+}
+template<unsigned int M, unsigned int N, typename Field>
+Field* Matrix<M, N, Field>::operator[](size_t pos) {
+    return row(pos);
 }
 template<unsigned int M, unsigned int N, typename Field>
-const vector<Field>& Matrix<M, N, Field>::operator[](size_t pos) const {
-    return table[pos];
+const Field* Matrix<M, N, Field>::operator[](size_t pos) const {
+    return row(pos);
 }
 template<unsigned int M, unsigned int N, typename Field>
 vector<Field> Matrix<M, N, Field>::getRow(unsigned index) {
-    return table[index];
+    return vector<Field>(row(index), row(index) + N);
 }
 template<unsigned int M, unsigned int N, typename Field>
 vector<Field> Matrix<M, N, Field>::getColumn(unsigned index) {
     vector<Field> result;
+    result.reserve(M);
     for (size_t i = 0; i < M; ++i)
-        result.push_back(table[i][index]);
+        result.push_back(row(i)[index]);
     return result;
 }
 
@@ -1031,16 +2703,12 @@ ostream& operator<<(ostream& out, const Matrix<M, N, Field>& matrix) {
 /////////////    MATHS    /////////////
 template<unsigned int M, unsigned int N, typename Field>
 Matrix<M, N, Field>& Matrix<M, N, Field>::operator+=(const Matrix<M, N, Field>& matrix) {
-    for (size_t i = 0; i < M; ++i)
-        for (size_t j = 0; j < N; ++j)
-            table[i][j] += matrix.table[i][j];
+    add_batch(table.data(), matrix.table.data(), table.size());
     return *this;
 }
 template<unsigned int M, unsigned int N, typename Field>
 Matrix<M, N, Field>& Matrix<M, N, Field>::operator-=(const Matrix<M, N, Field>& matrix) {
-    for (size_t i = 0; i < M; ++i)
-        for (size_t j = 0; j < N; ++j)
-            table[i][j] -= matrix.table[i][j];
+    sub_batch(table.data(), matrix.table.data(), table.size());
     return *this;
 }
 template<unsigned int M, unsigned int N, typename Field>
@@ -1057,9 +2725,7 @@ Matrix<M, N, Field> operator-(const Matrix<M, N, Field>& matrix1, const Matrix<M
 }
 template<unsigned int M, unsigned int N, typename Field>
 Matrix<M, N, Field>& Matrix<M, N, Field>::operator*=(const Field &f) {
-    for (size_t i = 0; i < M; ++i)
-        for (size_t j = 0; j < N; ++j)
-            table[i][j] *= f;
+    scale_batch(table.data(), f, table.size());
     return *this;
 }
 template<unsigned int M, unsigned int N, typename Field>
@@ -1077,30 +2743,25 @@ Matrix<M, N, Field> operator*(const Field& f, const Matrix<M, N, Field>& matrix)
 template<unsigned int M, unsigned int N, typename Field>
 Matrix<M, N, Field>& Matrix<M, N, Field>::operator*=(const Matrix<M, N, Field>& matrix) {
     static_assert(M == N, "Square Matrix needed");
-    vector<vector<Field>> copy = table;
-    for (size_t i = 0; i < N; ++i) {
-        for (size_t j = 0; j < N; ++j) {
-            table[i][j] = 0;
-            for (size_t p = 0; p < N; ++p) {
-                table[i][j] += copy[i][p] * matrix[p][j];
-            }
-        }
-    }
+    // произведение собирается в новом буфере, а старый остаётся множителем,
+    // в том числе при matrix == *this; таблица не копируется
+    Storage result;
+    allocate(result);
+    multiply_table(result.data(), N, table.data(), N, matrix.table.data(), N, M, N, N, Execution::sequential());
+    table = std::move(result);
     return *this;
 }
-template <unsigned int M, unsigned int N, unsigned int K, typename Field = Rational>
-Matrix<M, K, Field> operator*(const Matrix<M, N, Field>& matrix1, const Matrix<N, K, Field>& matrix2) {
+template <unsigned int M, unsigned int N, unsigned int K, typename Field>
+Matrix<M, K, Field> multiply(const Matrix<M, N, Field>& matrix1, const Matrix<N, K, Field>& matrix2, Execution policy) {
     Matrix<M, K, Field> result;
-    for (size_t i = 0; i < M; ++i) {
-        for (size_t j = 0; j < K; ++j) {
-            result[i][j] = 0;
-            for (size_t p = 0; p < N; ++p) {
-                result[i][j] += matrix1[i][p] * matrix2[p][j];
-            }
-        }
-    }
+    std::fill(result[0], result[0] + size_t(M) * K, Field(0));
+    multiply_table(result[0], K, matrix1[0], N, matrix2[0], K, M, N, K, policy);
     return result;
 }
+template <unsigned int M, unsigned int N, unsigned int K, typename Field = Rational>
+Matrix<M, K, Field> operator*(const Matrix<M, N, Field>& matrix1, const Matrix<N, K, Field>& matrix2) {
+    return multiply(matrix1, matrix2, Execution::sequential());
+}
 
 
 ///////////    METHODS    ///////////
@@ -1109,112 +2770,111 @@ Matrix<N, M, Field> Matrix<M, N, Field>::transposed() const {
     Matrix<N, M, Field> result;
     for (size_t i = 0; i < M; ++i)
         for (size_t j = 0; j < N; ++j)
-            result[j][i] = table[i][j];
+            result[j][i] = row(i)[j];
     return result;
 }
 template<unsigned int M, unsigned int N, typename Field>
-Matrix<M, N, Field> Matrix<M, N, Field>::inverted() const {
+Matrix<M, N, Field> Matrix<M, N, Field>::inverted(Execution policy) const {
     static_assert(M == N, "Square Matrix needed");
     Matrix<M, N, Field> inverted = *this;
-    return inverted.invert();
+    return inverted.invert(policy);
 }
+// строки, отличные от ведущей, обновляются независимо и делятся между потоками
 template<unsigned int M, unsigned int N, typename Field>
-Matrix<M, N, Field>& Matrix<M, N, Field>::invert() {
+Matrix<M, N, Field>& Matrix<M, N, Field>::invert(Execution policy) {
     static_assert(M == N, "Square Matrix needed");
     Matrix<M, N, Field> inverted;
     for (size_t i = 0; i < N; ++i) {
         size_t this_row = i;
         for (size_t j = i; j < N; ++j) {
-            if (table[j][i]) {
+            if (row(j)[i]) {
                 this_row = j;
                 break;
             }
         }
-        if (table[this_row][i] == 0)
+        if (row(this_row)[i] == 0)
             return *this = inverted;
         inverted.swapRows(i, this_row);
         swapRows(i, this_row);
-        for (size_t j = 0; j < N; ++j) {
-            if (j != i) {
-                Field k = table[j][i] / table[i][i];
-                for (size_t p = 0; p < N; ++p) {
-                    table[j][p] -= table[i][p] * k;
-                    inverted[j][p] -= inverted[i][p] * k;
-                }
-            }
-        }
-        Field k = table[i][i];
-        for (size_t j = 0; j < N; ++j) {
-            table[i][j] /= k;
-            inverted[i][j] /= k;
-        }
+        // одно обращение на ведущий элемент: строка сначала нормируется,
+        // и множителем для остальных строк становится сам элемент столбца
+        Field inverse = Field(1) / row(i)[i];
+        scale_batch(row(i), inverse, N);
+        scale_batch(inverted[i], inverse, N);
+        for_each_row<Field>(policy, 0, N, 2 * N, [&](size_t j) {
+            if (j == i || !row(j)[i])
+                return;
+            Field k = -row(j)[i];
+            axpy_batch(row(j), row(i), k, N);
+            axpy_batch(inverted[j], inverted[i], k, N);
+        });
     }
     return *this = inverted;
 }
+// у целочисленной матрицы ранг считается по простым модулям или Бареисом, у остальных — Гауссом
 template<unsigned int M, unsigned int N, typename Field>
-size_t Matrix<M, N, Field>::rank() const {
-    if (M < N) return transposed().rank();
-    Matrix<M, N, Field> copy = *this;
-    size_t rank = N;
-    for (size_t i = 0; i < N; ++i) {
-        size_t this_row = i;
-        for (size_t j = i; j < M; ++j) {
-            if (copy[j][i]) {
-                this_row = j;
-                break;
-            }
-        }
-        if (copy[this_row][i] == 0)
-            --rank;
-        else {
-            copy.swapRows(i, this_row);
-            for (size_t j = i + 1; j < M; ++j) {
-                Field k = copy[j][i] / copy[i][i];
-                for (size_t p = i; p < N; ++p)
-                    copy[j][p] -= copy[i][p] * k;
-            }
-        }
-    }
-    return rank;
+size_t Matrix<M, N, Field>::rank(Execution policy) const {
+    size_t rank;
+    if (integer_rank(table.data(), M, N, policy, rank))
+        return rank;
+    Storage copy = table;
+    return rank_table(copy.data(), M, N, policy);
 }
 template<unsigned int M, unsigned int N, typename Field>
 Field Matrix<M, N, Field>::trace() const {
     Field trace;
     size_t i = 0;
     while (i < M) {
-        trace += table[i][i];
+        trace += row(i)[i];
         ++i;
     }
     return trace;
 }
+// у целочисленной матрицы детерминант собирается по остаткам от простых модулей
+// или методом Бареиса, у остальных — Гауссом
 template<unsigned int M, unsigned int N, typename Field>
-Field Matrix<M, N, Field>::det() const {
+Field Matrix<M, N, Field>::det(Execution policy) const {
     static_assert(M == N, "Square Matrix needed");
-    Matrix<M, N, Field> copy = *this;
-    Field det = 1;
-    for (size_t i = 0; i < N; ++i) {
-        size_t this_row = i;
-        for (size_t j = i; j < N; ++j) {
-            if (copy[j][i]) {
-                this_row = j;
-                break;
-            }
-        }
-        if (copy[this_row][i] == 0) return 0;
-        copy.swapRows(i, this_row);
-        if (i != this_row)
-            det = -det;
-        det *= copy[i][i];
-        for (size_t j = i + 1; j < N; ++j) {
-            Field k = copy[j][i] / copy[i][i];
-            for (size_t p = i; p < N; ++p)
-                copy[j][p] -= copy[i][p] * k;
+    Field det;
+    if (integer_det(table.data(), N, policy, det))
+        return det;
+    Storage copy = table;
+    return det_table(copy.data(), N, policy);
+}
+
+// Матрица-компаньон возводится через остаток x^exponent по модулю её многочлена,
+// остальные — двоичным возведением слева направо: квадрат и, если бит взведён,
+// умножение на *this. Два буфера меняются ролями, промежуточные матрицы не копируются
+template<unsigned int M, unsigned int N, typename Field>
+Matrix<M, N, Field> Matrix<M, N, Field>::pow(uint64_t exponent, Execution policy) const {
+    static_assert(M == N, "Square Matrix needed");
+    Matrix<M, N, Field> power;
+    if (companion_power(power.table.data(), table.data(), N, exponent))
+        return power;
+    if (exponent == 0) {
+        for (size_t i = 0; i < N; ++i)
+            power.row(i)[i] = Field(1);
+        return power;
+    }
+    power.table = table;
+    Storage scratch;
+    allocate(scratch);
+    int bit = 63;
+    while (!(exponent >> bit & 1))
+        --bit;
+    while (bit-- > 0) {
+        std::fill(scratch.begin(), scratch.end(), Field(0));
+        multiply_table(scratch.data(), N, power.table.data(), N, power.table.data(), N, N, N, N, policy);
+        std::swap(power.table, scratch);
+        if (exponent >> bit & 1) {
+            std::fill(scratch.begin(), scratch.end(), Field(0));
+            multiply_table(scratch.data(), N, power.table.data(), N, table.data(), N, N, N, N, policy);
+            std::swap(power.table, scratch);
         }
     }
-    return det;
+    return power;
 }
 
-
 /////////////   LOGICAL    /////////////
 template<unsigned int M, unsigned int N, typename Field>
 bool operator==(const Matrix<M, N, Field>& matrix1, const Matrix<M, N, Field>& matrix2) {
@@ -1232,12 +2892,13 @@ bool operator!=(const Matrix<M, N, Field>& matrix1, const Matrix<M, N, Field>& m
 ///////    ADDITIONAL METHODS    ///////
 template<unsigned int M, unsigned int N, typename Field>
 void Matrix<M, N, Field>::swapRows(size_t i, size_t j) {
-    std::swap(table[i], table[j]);
+    if (i != j)
+        std::swap_ranges(row(i), row(i) + N, row(j));
 }
 template<unsigned int M, unsigned int N, typename Field>
 void Matrix<M, N, Field>::swapColumns(size_t i, size_t j) {
     for (size_t k = 0; k < M; ++k)
-        std::swap(table[k][i], table[k][j]);
+        std::swap(row(k)[i], row(k)[j]);
 }
 
 
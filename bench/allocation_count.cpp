@@ -0,0 +1,98 @@
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// Замена всех форм глобальных operator new/delete для профиля выделений в biginteger_bench:
+// каждое выделение, включая массивы, nothrow и выровненные, увеличивает allocation_count.
+// Замена живёт в своей единице трансляции: если компилятор встраивает её в место вызова,
+// он видит free на указателе от new и выдаёт -Wmismatched-new-delete
+std::atomic<size_t> allocation_count{0};
+
+namespace {
+
+void* allocate(size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+void* allocate(size_t size, std::align_val_t alignment) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    size_t align = static_cast<size_t>(alignment);
+    // aligned_alloc требует размер, кратный выравниванию
+    size_t rounded = (size + align - 1) / align * align;
+    return std::aligned_alloc(align, rounded ? rounded : align);
+}
+void* allocate_or_throw(size_t size) {
+    if (void* pointer = allocate(size))
+        return pointer;
+    throw std::bad_alloc();
+}
+void* allocate_or_throw(size_t size, std::align_val_t alignment) {
+    if (void* pointer = allocate(size, alignment))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+}
+
+void* operator new(size_t size) {
+    return allocate_or_throw(size);
+}
+void* operator new[](size_t size) {
+    return allocate_or_throw(size);
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+void* operator new(size_t size, std::align_val_t alignment) {
+    return allocate_or_throw(size, alignment);
+}
+void* operator new[](size_t size, std::align_val_t alignment) {
+    return allocate_or_throw(size, alignment);
+}
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate(size, alignment);
+}
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate(size, alignment);
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+void operator delete[](void* pointer) noexcept {
+    std::free(pointer);
+}
+void operator delete(void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
+void operator delete[](void* pointer, size_t) noexcept {
+    std::free(pointer);
+}
+void operator delete(void* pointer, const std::nothrow_t&) noexcept {
+    std::free(pointer);
+}
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept {
+    std::free(pointer);
+}
+void operator delete(void* pointer, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+void operator delete[](void* pointer, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+void operator delete(void* pointer, size_t, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+void operator delete[](void* pointer, size_t, std::align_val_t) noexcept {
+    std::free(pointer);
+}
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept {
+    std::free(pointer);
+}
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept {
+    std::free(pointer);
+}
@@ -0,0 +1,725 @@
+#include "biginteger.h"
+#include "fixedint.h"
+
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <sstream>
+
+// Профиль выделений памяти: глобальные operator new из allocation_count.cpp считают
+// вызовы, и каждый бенчмарк выводит счётчик allocs — среднее число выделений на итерацию
+extern std::atomic<size_t> allocation_count;
+
+// Операнды детерминированы: одинаковые в разных прогонах, чтобы JSON двух
+// версий можно было сравнивать через bench/compare.py
+namespace {
+
+string random_digits(size_t digits, uint64_t seed) {
+    std::mt19937_64 rng(seed * 1000003 + digits);
+    string s(1, static_cast<char>('1' + rng() % 9));
+    for (size_t i = 1; i < digits; ++i)
+        s += static_cast<char>('0' + rng() % 10);
+    return s;
+}
+BigInteger random_number(size_t digits, uint64_t seed) {
+    return BigInteger(random_digits(digits, seed));
+}
+
+// считает выделения от создания до конца цикла бенчмарка
+class AllocationCounter {
+private:
+    benchmark::State& state;
+    size_t start;
+public:
+    explicit AllocationCounter(benchmark::State& state)
+        : state(state), start(allocation_count.load(std::memory_order_relaxed)) {}
+    ~AllocationCounter() {
+        double count = allocation_count.load(std::memory_order_relaxed) - start;
+        state.counters["allocs"] = benchmark::Counter(count, benchmark::Counter::kAvgIterations);
+    }
+};
+
+// размеры в десятичных цифрах
+void integer_sizes(benchmark::internal::Benchmark* bench) {
+    bench->RangeMultiplier(4)->Range(16, 4096)->Complexity();
+}
+void rational_sizes(benchmark::internal::Benchmark* bench) {
+    bench->RangeMultiplier(4)->Range(16, 1024)->Complexity();
+}
+
+
+/////////////    BIGINTEGER    /////////////
+void BM_Add(benchmark::State& state) {
+    size_t digits = state.range(0);
+    BigInteger a = random_number(digits, 1), b = random_number(digits, 2);
+    AllocationCounter allocations(state);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(a + b);
+    state.SetComplexityN(digits);
+}
+BENCHMARK(BM_Add)->Apply(integer_sizes);
+
+void BM_Sub(benchmark::State& state) {
+    size_t digits = state.range(0);
+    BigInteger a = random_number(digits, 1), b = random_number(digits, 2);
+    AllocationCounter allocations(state);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(a - b);
+    state.SetComplexityN(digits);
+}
+BENCHMARK(BM_Sub)->Apply(integer_sizes);
+
+// x += y; x -= y ядрами add_kernel/sub_kernel (AVX2, если есть)
+void BM_AddSub(benchmark::State& state) {
+    size_t digits = state.range(0);
+    BigInteger x = random_number(digits, 1), y = random_number(digits, 2);
+    for (auto _ : state) {
+        x += y;
+        x -= y;
+        benchmark::DoNotOptimize(x);
+    }
+    state.SetComplexityN(digits);
+}
+BENCHMARK(BM_AddSub)->RangeMultiplier(10)->Range(100, 100000)->Complexity(benchmark::oN);
+
+// прежние циклы operator+= и subtraction: разряд за разрядом, с ветвлением по переносу
+// и push_back посреди цикла; разряды по основанию 10^4, младшие первыми
+vector<int> decimal_limbs(const string& digits) {
+    vector<int> limbs;
+    for (size_t end = digits.size(); end > 0; end -= std::min<size_t>(end, 4)) {
+        size_t begin = end - std::min<size_t>(end, 4);
+        limbs.push_back(std::stoi(digits.substr(begin, end - begin)));
+    }
+    return limbs;
+}
+void legacy_add(vector<int>& bits, const vector<int>& num) {
+    int carry = 0;
+    for (size_t i = 0; i < max(bits.size(), num.size()) || carry; ++i) {
+        if (i == bits.size())
+            bits.push_back(0);
+        bits[i] += carry + (i < num.size() ? num[i] : 0);
+        carry = bits[i] >= 10000;
+        if (carry)
+            bits[i] -= 10000;
+    }
+}
+void legacy_sub(vector<int>& bits, const vector<int>& smaller) {
+    int carry = 0;
+    for (size_t i = 0; i < smaller.size() || carry; ++i) {
+        bits[i] = bits[i] - carry - (i < smaller.size() ? smaller[i] : 0);
+        carry = bits[i] < 0;
+        if (carry)
+            bits[i] += 10000;
+    }
+    while (bits.size() > 1 && bits.back() == 0)
+        bits.pop_back();
+}
+void BM_AddSubLegacy(benchmark::State& state) {
+    size_t digits = state.range(0);
+    vector<int> x = decimal_limbs(random_digits(digits, 1)), y = decimal_limbs(random_digits(digits, 2));
+    for (auto _ : state) {
+        legacy_add(x, y);
+        legacy_sub(x, y);
+        benchmark::DoNotOptimize(x.data());
+    }
+    state.SetComplexityN(digits);
+}
+BENCHMARK(BM_AddSubLegacy)->RangeMultiplier(10)->Range(100, 100000)->Complexity(benchmark::oN);
+
+void BM_Mul(benchmark::State& state) {
+    size_t digits = state.range(0);
+    BigInteger a = random_number(digits, 1), b = random_number(digits, 2);
+    AllocationCounter allocations(state);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(a * b);
+    state.SetComplexityN(digits);
+}
+BENCHMARK(BM_Mul)->Apply(integer_sizes);
+
+// произведение двух чисел по 10^6 цифр при setThreadCount(1, 2, 4, 8);
+// speedup — отношение ко времени одного потока, который регистрируется первым
+void BM_MulThreads(benchmark::State& state) {
+    static double single_thread_seconds = 0;
+    size_t digits = state.range(0);
+    unsigned threads = static_cast<unsigned>(state.range(1));
+    BigInteger a = random_number(digits, 1), b = random_number(digits, 2);
+    unsigned previous = BigInteger::getThreadCount();
+    BigInteger::setThreadCount(threads);
+    auto start = std::chrono::steady_clock::now();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(a * b);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / state.iterations();
+    BigInteger::setThreadCount(previous);
+    if (threads == 1)
+        single_thread_seconds = seconds;
+    if (single_thread_seconds > 0)
+        state.counters["speedup"] = single_thread_seconds / seconds;
+}
+BENCHMARK(BM_MulThreads)->ArgsProduct({{1000000}, {1, 2, 4, 8}})->ArgNames({"digits", "threads"})
+    ->UseRealTime()->Unit(benchmark::kSecond);
+
+// делимое вдвое длиннее делителя: частное и делитель одной длины
+void BM_Div(benchmark::State& state) {
+    size_t digits = state.range(0);
+    BigInteger a = random_number(2 * digits, 1), b = random_number(digits, 2);
+    AllocationCounter allocations(state);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(a / b);
+    state.SetComplexityN(digits);
+}
+BENCHMARK(BM_Div)->Apply(integer_sizes);
+
+void BM_Mod(benchmark::State& state) {
+    size_t digits = state.range(0);
+    BigInteger a = random_number(2 * digits, 1), b = random_number(digits, 2);
+    AllocationCounter allocations(state);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(a % b);
+    state.SetComplexityN(digits);
+}
+BENCHMARK(BM_Mod)->Apply(integer_sizes);
+
+void BM_Gcd(benchmark::State& state) {
+    size_t digits = state.range(0);
+    BigInteger a = random_number(digits, 1), b = random_number(digits, 2);
+    AllocationCounter allocations(state);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(greatest_common_divisor(a, b));
+    state.SetComplexityN(digits);
+}
+BENCHMARK(BM_Gcd)->Apply(integer_sizes);
+
+// двоичные операции переводят десятичные разряды в 32-битные слова и обратно
+void BM_BitAnd(benchmark::State& state) {
+    size_t digits = state.range(0);
+    BigInteger a = random_number(digits, 1), b = random_number(digits, 2);
+    AllocationCounter allocations(state);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(a & b);
+    state.SetComplexityN(digits);
+}
+BENCHMARK(BM_BitAnd)->Apply(integer_sizes);
+
+// сдвиг на половину длины числа в битах
+void BM_ShiftRight(benchmark::State& state) {
+    size_t digits = state.range(0);
+    BigInteger a = random_number(digits, 1);
+    size_t shift = digits * 332 / 200;
+    AllocationCounter allocations(state);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(a >> shift);
+    state.SetComplexityN(digits);
+}
+BENCHMARK(BM_ShiftRight)->Apply(integer_sizes);
+
+// x >> bits против bits вызовов div2 на числе в 2000 цифр: сдвиг снимает по 16 бит за проход
+void BM_ShiftRightBits(benchmark::State& state) {
+    BigInteger a = random_number(2000, 1);
+    size_t shift = state.range(0);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(a >> shift);
+}
+BENCHMARK(BM_ShiftRightBits)->Arg(1)->Arg(16)->Arg(1000);
+
+void BM_Div2Loop(benchmark::State& state) {
+    BigInteger a = random_number(2000, 1);
+    size_t shift = state.range(0);
+    for (auto _ : state) {
+        BigInteger copy = a;
+        for (size_t i = 0; i < shift; ++i)
+            copy.div2();
+        benchmark::DoNotOptimize(copy);
+    }
+}
+BENCHMARK(BM_Div2Loop)->Arg(1)->Arg(16)->Arg(1000);
+
+void BM_ToString(benchmark::State& state) {
+    size_t digits = state.range(0);
+    BigInteger a = random_number(digits, 1);
+    AllocationCounter allocations(state);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(a.toString());
+    state.SetComplexityN(digits);
+    state.SetBytesProcessed(state.iterations() * digits);
+}
+BENCHMARK(BM_ToString)->Apply(integer_sizes);
+
+void BM_ParseString(benchmark::State& state) {
+    size_t digits = state.range(0);
+    string s = random_digits(digits, 1);
+    BigInteger a;
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        a.parseString(s);
+        benchmark::DoNotOptimize(a);
+    }
+    state.SetComplexityN(digits);
+    state.SetBytesProcessed(state.iterations() * digits);
+}
+BENCHMARK(BM_ParseString)->Apply(integer_sizes);
+
+// 1024 числа через пробел из istringstream: operator>> разбирает цифры прямо в окне буфера
+void BM_ParseStream(benchmark::State& state) {
+    size_t digits = state.range(0);
+    string data;
+    for (uint64_t i = 0; i < 1024; ++i)
+        data += random_digits(digits, i) + ' ';
+    BigInteger a;
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        std::istringstream in(data);
+        while (in >> a)
+            benchmark::DoNotOptimize(a);
+    }
+    state.SetItemsProcessed(state.iterations() * 1024);
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_ParseStream)->RangeMultiplier(4)->Range(4, 4096);
+
+
+/////////////    NUMBER THEORY    /////////////
+// наивные версии — то, что раньше писалось на месте вызова: бисекция по ответу
+// и возведение в степень через %= без контекста модуля
+BigInteger naive_pow(const BigInteger& num, size_t deg) {
+    BigInteger result = 1;
+    for (size_t i = 0; i < deg; ++i)
+        result *= num;
+    return result;
+}
+BigInteger bisection_root(const BigInteger& num, size_t deg) {
+    BigInteger low = 0, high = BigInteger(1) << (num.bit_length() / deg + 1);
+    while (low < high) {
+        BigInteger middle = (low + high + 1) / 2;
+        if (naive_pow(middle, deg) <= num)
+            low = middle;
+        else
+            high = middle - 1;
+    }
+    return low;
+}
+BigInteger naive_powmod(BigInteger num, BigInteger deg, const BigInteger& mod) {
+    BigInteger result = 1;
+    num %= mod;
+    while (deg != 0) {
+        if (!deg.isEven()) {
+            result *= num;
+            result %= mod;
+        }
+        num *= num;
+        num %= mod;
+        deg /= 2;
+    }
+    return result;
+}
+
+void BM_Isqrt(benchmark::State& state) {
+    BigInteger a = random_number(state.range(0), 1);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(isqrt(a));
+}
+BENCHMARK(BM_Isqrt)->Arg(100)->Arg(300)->Unit(benchmark::kMicrosecond);
+
+void BM_IsqrtBisection(benchmark::State& state) {
+    BigInteger a = random_number(state.range(0), 1);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(bisection_root(a, 2));
+}
+BENCHMARK(BM_IsqrtBisection)->Arg(100)->Arg(300)->Unit(benchmark::kMicrosecond);
+
+void BM_Iroot5(benchmark::State& state) {
+    BigInteger a = random_number(state.range(0), 1);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(iroot(a, 5));
+}
+BENCHMARK(BM_Iroot5)->Arg(300)->Unit(benchmark::kMicrosecond);
+
+void BM_Iroot5Bisection(benchmark::State& state) {
+    BigInteger a = random_number(state.range(0), 1);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(bisection_root(a, 5));
+}
+BENCHMARK(BM_Iroot5Bisection)->Arg(300)->Unit(benchmark::kMicrosecond);
+
+// 7^100 — точная степень, так что перебираются все простые показатели
+void BM_PerfectPower(benchmark::State& state) {
+    BigInteger a = naive_pow(7, 100) + 1;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(is_perfect_power(a));
+}
+BENCHMARK(BM_PerfectPower)->Unit(benchmark::kMillisecond);
+
+void BM_PerfectPowerBisection(benchmark::State& state) {
+    BigInteger a = naive_pow(7, 100) + 1;
+    for (auto _ : state) {
+        bool found = false;
+        for (size_t deg = 2; deg <= a.bit_length() && !found; ++deg)
+            found = naive_pow(bisection_root(a, deg), deg) == a;
+        benchmark::DoNotOptimize(found);
+    }
+}
+BENCHMARK(BM_PerfectPowerBisection)->Unit(benchmark::kMillisecond);
+
+// 2^521 - 1 — простое Мерсенна: Миллер — Рабин проходит все 20 оснований
+void BM_MillerRabin(benchmark::State& state) {
+    BigInteger p = (BigInteger(1) << 521) - 1;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(is_probable_prime(p));
+}
+BENCHMARK(BM_MillerRabin)->Unit(benchmark::kMillisecond);
+
+// один тест Ферма по основанию 2 через %=
+void BM_FermatNaive(benchmark::State& state) {
+    BigInteger p = (BigInteger(1) << 521) - 1;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(naive_powmod(2, p - 1, p) == 1);
+}
+BENCHMARK(BM_FermatNaive)->Unit(benchmark::kMillisecond);
+
+void BM_ModInverse(benchmark::State& state) {
+    BigInteger p = (BigInteger(1) << 521) - 1, a = random_number(150, 1);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(mod_inverse(a, p));
+}
+BENCHMARK(BM_ModInverse)->Unit(benchmark::kMicrosecond);
+
+// a^(p - 2) по простому модулю
+void BM_ModInverseFermat(benchmark::State& state) {
+    BigInteger p = (BigInteger(1) << 521) - 1, a = random_number(150, 1);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(naive_powmod(a, p - 2, p));
+}
+BENCHMARK(BM_ModInverseFermat)->Unit(benchmark::kMicrosecond);
+
+/////////////    SMALL    /////////////
+// значения до 18 цифр живут в long long и не выделяют память; allocs должен быть 0
+void BM_SmallMixed(benchmark::State& state) {
+    std::mt19937_64 rng(1);
+    vector<BigInteger> nums;
+    for (size_t i = 0; i < 1024; ++i)
+        nums.push_back(BigInteger(static_cast<long long>(rng() % 1000000000) + 1));
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        BigInteger acc = 1;
+        for (const BigInteger& num : nums) {
+            acc += num;
+            acc *= 3;
+            acc /= 2;
+            acc %= num;
+            if (acc == 1)
+                ++acc;
+        }
+        benchmark::DoNotOptimize(acc);
+    }
+    state.SetItemsProcessed(state.iterations() * nums.size());
+}
+BENCHMARK(BM_SmallMixed);
+
+// range(0) процентов множителей — числа по 100 цифр, остальные — до 7 цифр,
+// так что без длинных слагаемых вся сумма помещается в long long
+void BM_MixedSizes(benchmark::State& state) {
+    std::mt19937_64 rng(2);
+    vector<BigInteger> nums1, nums2;
+    for (uint64_t i = 0; i < 1024; ++i) {
+        bool large = static_cast<int64_t>(rng() % 100) < state.range(0);
+        nums1.push_back(large ? random_number(100, i) : BigInteger(static_cast<long long>(rng() % 10000000)));
+        nums2.push_back(BigInteger(static_cast<long long>(rng() % 100000000)));
+    }
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        BigInteger sum = 0;
+        for (size_t i = 0; i < nums1.size(); ++i)
+            sum += nums1[i] * nums2[i];
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * nums1.size());
+}
+BENCHMARK(BM_MixedSizes)->Arg(0)->Arg(10)->Arg(50)->Arg(100);
+
+/////////////    BATCH    /////////////
+// 4096 пар случайной длины до range(0) цифр: пакет в одном буфере против цикла по vector<BigInteger>
+vector<BigInteger> batch_numbers(size_t max_digits, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    vector<BigInteger> nums;
+    for (uint64_t i = 0; i < 4096; ++i)
+        nums.push_back(random_number(1 + rng() % max_digits, seed * 4096 + i));
+    return nums;
+}
+
+void BM_MulBatch(benchmark::State& state) {
+    BigIntegerBatch batch1(batch_numbers(state.range(0), 1)), batch2(batch_numbers(state.range(0), 2));
+    AllocationCounter allocations(state);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(mul_batch(batch1, batch2));
+    state.SetItemsProcessed(state.iterations() * batch1.size());
+}
+BENCHMARK(BM_MulBatch)->Arg(40)->Arg(400)->Unit(benchmark::kMillisecond);
+
+void BM_MulLoop(benchmark::State& state) {
+    vector<BigInteger> nums1 = batch_numbers(state.range(0), 1), nums2 = batch_numbers(state.range(0), 2);
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        vector<BigInteger> result = nums1;
+        for (size_t i = 0; i < result.size(); ++i)
+            result[i] *= nums2[i];
+        benchmark::DoNotOptimize(result.data());
+    }
+    state.SetItemsProcessed(state.iterations() * nums1.size());
+}
+BENCHMARK(BM_MulLoop)->Arg(40)->Arg(400)->Unit(benchmark::kMillisecond);
+
+void BM_ModBatch(benchmark::State& state) {
+    BigIntegerBatch batch(batch_numbers(state.range(0), 1));
+    ModContext context(random_number(state.range(0) / 2, 3) + 1);
+    AllocationCounter allocations(state);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(mod_batch(batch, context));
+    state.SetItemsProcessed(state.iterations() * batch.size());
+}
+BENCHMARK(BM_ModBatch)->Arg(40)->Arg(400)->Unit(benchmark::kMillisecond);
+
+void BM_ModLoop(benchmark::State& state) {
+    vector<BigInteger> nums = batch_numbers(state.range(0), 1);
+    BigInteger mod = random_number(state.range(0) / 2, 3) + 1;
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        vector<BigInteger> result = nums;
+        for (BigInteger& num : result)
+            num %= mod;
+        benchmark::DoNotOptimize(result.data());
+    }
+    state.SetItemsProcessed(state.iterations() * nums.size());
+}
+BENCHMARK(BM_ModLoop)->Arg(40)->Arg(400)->Unit(benchmark::kMillisecond);
+
+/////////////    BINARY FORMAT    /////////////
+// 256 чисел по range(0) цифр; bytes — размер потока, так что текст и двоичный
+// формат сравниваются и по скорости (MB/s по своему размеру), и по объёму
+vector<BigInteger> serial_numbers(size_t digits) {
+    vector<BigInteger> nums;
+    for (uint64_t i = 0; i < 256; ++i)
+        nums.push_back(i % 2 ? random_number(digits, i) : -random_number(digits, i));
+    return nums;
+}
+string text_stream(const vector<BigInteger>& nums) {
+    std::ostringstream out;
+    for (const BigInteger& num : nums)
+        out << num << ' ';
+    return out.str();
+}
+string binary_stream(const vector<BigInteger>& nums) {
+    std::ostringstream out;
+    writeBinary(out, nums);
+    return out.str();
+}
+
+void BM_WriteText(benchmark::State& state) {
+    vector<BigInteger> nums = serial_numbers(state.range(0));
+    size_t size = text_stream(nums).size();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(text_stream(nums));
+    state.counters["bytes"] = size;
+    state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_WriteText)->RangeMultiplier(8)->Range(8, 4096);
+
+void BM_WriteBinary(benchmark::State& state) {
+    vector<BigInteger> nums = serial_numbers(state.range(0));
+    size_t size = binary_stream(nums).size();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(binary_stream(nums));
+    state.counters["bytes"] = size;
+    state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_WriteBinary)->RangeMultiplier(8)->Range(8, 4096);
+
+void BM_ReadText(benchmark::State& state) {
+    string data = text_stream(serial_numbers(state.range(0)));
+    vector<BigInteger> nums(256);
+    for (auto _ : state) {
+        std::istringstream in(data);
+        for (BigInteger& num : nums)
+            in >> num;
+        benchmark::DoNotOptimize(nums.data());
+    }
+    state.counters["bytes"] = data.size();
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_ReadText)->RangeMultiplier(8)->Range(8, 4096);
+
+void BM_ReadBinary(benchmark::State& state) {
+    string data = binary_stream(serial_numbers(state.range(0)));
+    vector<BigInteger> nums;
+    for (auto _ : state) {
+        std::istringstream in(data);
+        readBinary(in, nums);
+        benchmark::DoNotOptimize(nums.data());
+    }
+    state.counters["bytes"] = data.size();
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_ReadBinary)->RangeMultiplier(8)->Range(8, 4096);
+
+/////////////    FIXED WIDTH    /////////////
+// 1024 пары по 37 цифр (около 123 бит): произведение ещё помещается в FixedInt<256>,
+// а BigInteger на таких длинах уже хранит разряды в куче
+template <typename Number>
+vector<Number> width_numbers(uint64_t seed) {
+    vector<Number> nums;
+    for (uint64_t i = 0; i < 1024; ++i)
+        nums.push_back(Number(random_digits(37, seed * 1024 + i)));
+    return nums;
+}
+
+template <typename Number>
+void BM_WidthAdd(benchmark::State& state) {
+    vector<Number> nums1 = width_numbers<Number>(1), nums2 = width_numbers<Number>(2);
+    AllocationCounter allocations(state);
+    for (auto _ : state)
+        for (size_t i = 0; i < nums1.size(); ++i)
+            benchmark::DoNotOptimize(nums1[i] + nums2[i]);
+    state.SetItemsProcessed(state.iterations() * nums1.size());
+}
+BENCHMARK_TEMPLATE(BM_WidthAdd, FixedInt<256>);
+BENCHMARK_TEMPLATE(BM_WidthAdd, BigInteger);
+
+template <typename Number>
+void BM_WidthMul(benchmark::State& state) {
+    vector<Number> nums1 = width_numbers<Number>(1), nums2 = width_numbers<Number>(2);
+    AllocationCounter allocations(state);
+    for (auto _ : state)
+        for (size_t i = 0; i < nums1.size(); ++i)
+            benchmark::DoNotOptimize(nums1[i] * nums2[i]);
+    state.SetItemsProcessed(state.iterations() * nums1.size());
+}
+BENCHMARK_TEMPLATE(BM_WidthMul, FixedInt<256>);
+BENCHMARK_TEMPLATE(BM_WidthMul, BigInteger);
+
+template <typename Number>
+void BM_WidthMulDiv(benchmark::State& state) {
+    vector<Number> nums1 = width_numbers<Number>(1), nums2 = width_numbers<Number>(2);
+    AllocationCounter allocations(state);
+    for (auto _ : state)
+        for (size_t i = 0; i < nums1.size(); ++i)
+            benchmark::DoNotOptimize(nums1[i] * nums2[i] / nums1[i]);
+    state.SetItemsProcessed(state.iterations() * nums1.size());
+}
+BENCHMARK_TEMPLATE(BM_WidthMulDiv, FixedInt<256>);
+BENCHMARK_TEMPLATE(BM_WidthMulDiv, BigInteger);
+
+/////////////    RATIONAL    /////////////
+// числитель и знаменатель по digits цифр, дроби несократимы не обязательно
+Rational random_rational(size_t digits, uint64_t seed) {
+    return Rational(random_number(digits, seed), random_number(digits, seed + 100));
+}
+
+void BM_RationalAdd(benchmark::State& state) {
+    size_t digits = state.range(0);
+    Rational a = random_rational(digits, 1), b = random_rational(digits, 2);
+    AllocationCounter allocations(state);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(a + b);
+    state.SetComplexityN(digits);
+}
+BENCHMARK(BM_RationalAdd)->Apply(rational_sizes);
+
+void BM_RationalMul(benchmark::State& state) {
+    size_t digits = state.range(0);
+    Rational a = random_rational(digits, 1), b = random_rational(digits, 2);
+    AllocationCounter allocations(state);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(a * b);
+    state.SetComplexityN(digits);
+}
+BENCHMARK(BM_RationalMul)->Apply(rational_sizes);
+
+void BM_RationalDiv(benchmark::State& state) {
+    size_t digits = state.range(0);
+    Rational a = random_rational(digits, 1), b = random_rational(digits, 2);
+    AllocationCounter allocations(state);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(a / b);
+    state.SetComplexityN(digits);
+}
+BENCHMARK(BM_RationalDiv)->Apply(rational_sizes);
+
+void BM_RationalLess(benchmark::State& state) {
+    size_t digits = state.range(0);
+    Rational a = random_rational(digits, 1), b = random_rational(digits, 2);
+    AllocationCounter allocations(state);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(a < b);
+    state.SetComplexityN(digits);
+}
+BENCHMARK(BM_RationalLess)->Apply(rational_sizes);
+
+void BM_RationalAsDecimal(benchmark::State& state) {
+    size_t digits = state.range(0);
+    Rational a = random_rational(digits, 1);
+    AllocationCounter allocations(state);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(a.asDecimal(digits));
+    state.SetComplexityN(digits);
+}
+BENCHMARK(BM_RationalAsDecimal)->Apply(rational_sizes);
+
+// сортировка 4096 дробей; копия каждый раз новая, так что отрезки тоже считаются заново
+void rational_sort(benchmark::State& state, bool cache) {
+    size_t digits = state.range(0);
+    vector<Rational> nums;
+    for (uint64_t seed = 0; seed < 4096; ++seed)
+        nums.push_back(random_rational(digits, seed));
+    bool previous = Rational::getIntervalCache();
+    Rational::setIntervalCache(cache);
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        vector<Rational> copy = nums;
+        std::sort(copy.begin(), copy.end());
+        benchmark::DoNotOptimize(copy.data());
+    }
+    Rational::setIntervalCache(previous);
+    state.SetItemsProcessed(state.iterations() * nums.size());
+}
+void BM_RationalSort(benchmark::State& state) {
+    rational_sort(state, true);
+}
+BENCHMARK(BM_RationalSort)->RangeMultiplier(4)->Range(16, 256)->Unit(benchmark::kMillisecond);
+
+void BM_RationalSortExact(benchmark::State& state) {
+    rational_sort(state, false);
+}
+BENCHMARK(BM_RationalSortExact)->RangeMultiplier(4)->Range(16, 256)->Unit(benchmark::kMillisecond);
+
+// гармонический ряд 1 + 1/2 + ... + 1/n: знаменатель суммы растёт как НОК(1..n)
+vector<Rational> harmonic_terms(size_t count) {
+    vector<Rational> terms;
+    terms.reserve(count);
+    for (size_t i = 1; i <= count; ++i)
+        terms.push_back(Rational(1, BigInteger(i)));
+    return terms;
+}
+
+void BM_HarmonicNaive(benchmark::State& state) {
+    vector<Rational> terms = harmonic_terms(state.range(0));
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        Rational sum = 0;
+        for (const Rational& q : terms)
+            sum += q;
+        benchmark::DoNotOptimize(sum);
+    }
+}
+BENCHMARK(BM_HarmonicNaive)->RangeMultiplier(10)->Range(100, 1000)->Unit(benchmark::kMillisecond);
+
+void BM_HarmonicSum(benchmark::State& state) {
+    vector<Rational> terms = harmonic_terms(state.range(0));
+    AllocationCounter allocations(state);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(RationalSum(terms).total());
+}
+BENCHMARK(BM_HarmonicSum)->RangeMultiplier(10)->Range(100, 100000)->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
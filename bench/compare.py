@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+"""Сравнение двух JSON-отчётов Google Benchmark.
+
+    python3 bench/compare.py old.json new.json [--threshold 0.10] [--metric real_time]
+
+Печатает для каждого общего бенчмарка время до и после и относительное
+изменение. Замедление больше порога помечается REGRESSION, и тогда скрипт
+завершается с кодом 1. Если прогон делался с --benchmark_repetitions,
+берётся агрегат median.
+"""
+
+import argparse
+import json
+import sys
+
+UNIT_TO_NS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def load(path, metric):
+    with open(path) as f:
+        report = json.load(f)
+    plain, medians = {}, {}
+    for bench in report.get("benchmarks", []):
+        if bench.get("error_occurred"):
+            continue
+        value = bench.get(metric)
+        if value is None:
+            continue
+        # big-O и RMS из Complexity() не являются временем одного прогона
+        if bench.get("aggregate_name") in ("BigO", "RMS"):
+            continue
+        value *= UNIT_TO_NS.get(bench.get("time_unit", "ns"), 1.0)
+        name = bench.get("run_name", bench["name"])
+        if bench.get("run_type") == "aggregate":
+            if bench.get("aggregate_name") == "median":
+                medians[name] = value
+        else:
+            plain.setdefault(name, value)
+    plain.update(medians)
+    return plain
+
+
+def format_time(ns):
+    for unit, scale in (("s", 1e9), ("ms", 1e6), ("us", 1e3)):
+        if ns >= scale:
+            return f"{ns / scale:.3f} {unit}"
+    return f"{ns:.1f} ns"
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Flag benchmark regressions between two runs")
+    parser.add_argument("old")
+    parser.add_argument("new")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="relative slowdown that counts as a regression (default 0.10)")
+    parser.add_argument("--metric", default="real_time", choices=("real_time", "cpu_time"))
+    args = parser.parse_args()
+
+    old, new = load(args.old, args.metric), load(args.new, args.metric)
+    common = [name for name in old if name in new]
+    if not common:
+        print("no common benchmarks", file=sys.stderr)
+        return 2
+
+    width = max(len(name) for name in common)
+    regressions = 0
+    print(f"{'benchmark':<{width}}  {'old':>12}  {'new':>12}  {'change':>8}")
+    for name in common:
+        change = new[name] / old[name] - 1.0 if old[name] > 0 else 0.0
+        mark = ""
+        if change > args.threshold:
+            mark = "  REGRESSION"
+            regressions += 1
+        elif change < -args.threshold:
+            mark = "  improved"
+        print(f"{name:<{width}}  {format_time(old[name]):>12}  {format_time(new[name]):>12}  {change:+8.1%}{mark}")
+
+    only_old, only_new = len(set(old) - set(new)), len(set(new) - set(old))
+    if only_old or only_new:
+        print(f"\nskipped: {only_old} only in {args.old}, {only_new} only in {args.new}")
+    print(f"\n{regressions} regression(s) above {args.threshold:.0%}")
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,423 @@
+#include "matrix.h"
+
+#include <benchmark/benchmark.h>
+#include <random>
+
+// Размеры матриц — параметры шаблона, поэтому каждый размер регистрируется
+// отдельно через BENCHMARK_TEMPLATE; элементы детерминированы, как в biginteger_bench
+namespace {
+
+const int prime = 1000000007;
+using Field = Finite<prime>;
+
+vector<vector<int>> random_table(unsigned rows, unsigned columns, int bound, uint64_t seed) {
+    std::mt19937_64 rng(seed * 1000003 + rows * 1009 + columns);
+    vector<vector<int>> table(rows, vector<int>(columns));
+    for (vector<int>& row : table)
+        for (int& el : row)
+            el = static_cast<int>(rng() % bound);
+    return table;
+}
+
+
+/////////////    STORAGE    /////////////
+template <unsigned Size>
+void BM_Construct(benchmark::State& state) {
+    for (auto _ : state) {
+        Matrix<Size, Size, double> matrix;
+        benchmark::DoNotOptimize(matrix[0]);
+    }
+}
+BENCHMARK_TEMPLATE(BM_Construct, 4);
+BENCHMARK_TEMPLATE(BM_Construct, 16);
+BENCHMARK_TEMPLATE(BM_Construct, 64);
+BENCHMARK_TEMPLATE(BM_Construct, 256);
+BENCHMARK_TEMPLATE(BM_Construct, 1024);
+
+template <unsigned Size>
+void BM_Copy(benchmark::State& state) {
+    Matrix<Size, Size, double> matrix(random_table(Size, Size, 1000, 1));
+    for (auto _ : state) {
+        Matrix<Size, Size, double> copy = matrix;
+        benchmark::DoNotOptimize(copy[0]);
+    }
+}
+BENCHMARK_TEMPLATE(BM_Copy, 4);
+BENCHMARK_TEMPLATE(BM_Copy, 16);
+BENCHMARK_TEMPLATE(BM_Copy, 64);
+BENCHMARK_TEMPLATE(BM_Copy, 256);
+BENCHMARK_TEMPLATE(BM_Copy, 1024);
+
+template <unsigned Size>
+void BM_Multiply(benchmark::State& state) {
+    Matrix<Size, Size, double> matrix1(random_table(Size, Size, 1000, 1));
+    Matrix<Size, Size, double> matrix2(random_table(Size, Size, 1000, 2));
+    for (auto _ : state)
+        benchmark::DoNotOptimize((matrix1 * matrix2)[0]);
+    state.counters["flops"] = benchmark::Counter(2.0 * Size * Size * Size, benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK_TEMPLATE(BM_Multiply, 4);
+BENCHMARK_TEMPLATE(BM_Multiply, 16);
+BENCHMARK_TEMPLATE(BM_Multiply, 64);
+BENCHMARK_TEMPLATE(BM_Multiply, 256)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Multiply, 1024)->Unit(benchmark::kMillisecond);
+
+template <unsigned Size>
+void BM_MultiplyFloat(benchmark::State& state) {
+    Matrix<Size, Size, float> matrix1(random_table(Size, Size, 1000, 1));
+    Matrix<Size, Size, float> matrix2(random_table(Size, Size, 1000, 2));
+    for (auto _ : state)
+        benchmark::DoNotOptimize((matrix1 * matrix2)[0]);
+    state.counters["flops"] = benchmark::Counter(2.0 * Size * Size * Size, benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK_TEMPLATE(BM_MultiplyFloat, 256)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_MultiplyFloat, 1024)->Unit(benchmark::kMillisecond);
+
+// умножение на себя через *=: без копии таблицы и с тем же буфером справа
+template <unsigned Size>
+void BM_MultiplyAssign(benchmark::State& state) {
+    Matrix<Size, Size, double> matrix(random_table(Size, Size, 2, 1));
+    for (auto _ : state) {
+        Matrix<Size, Size, double> power = matrix;
+        power *= power;
+        benchmark::DoNotOptimize(power[0]);
+    }
+}
+BENCHMARK_TEMPLATE(BM_MultiplyAssign, 256)->Unit(benchmark::kMillisecond);
+
+// точная арифметика: до 32 построчный путь, дальше целые записи идут по Винограду
+template <unsigned Size>
+void BM_RationalMultiply(benchmark::State& state) {
+    Matrix<Size, Size> matrix1(random_table(Size, Size, 1000, 1));
+    Matrix<Size, Size> matrix2(random_table(Size, Size, 1000, 2));
+    for (auto _ : state)
+        benchmark::DoNotOptimize((matrix1 * matrix2)[0]);
+}
+BENCHMARK_TEMPLATE(BM_RationalMultiply, 16)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_RationalMultiply, 32)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_RationalMultiply, 64)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_RationalMultiply, 128)->Unit(benchmark::kMillisecond);
+
+// то же без Винограда: все 8 умножений блоков построчным gemm
+template <unsigned Size>
+void BM_RationalGemm(benchmark::State& state) {
+    Matrix<Size, Size> matrix1(random_table(Size, Size, 1000, 1));
+    Matrix<Size, Size> matrix2(random_table(Size, Size, 1000, 2));
+    for (auto _ : state) {
+        Matrix<Size, Size> result(vector<vector<int>>(Size, vector<int>(Size)));
+        gemm(result[0], Size, matrix1[0], Size, matrix2[0], Size, Size, Size, Size);
+        benchmark::DoNotOptimize(result[0]);
+    }
+}
+BENCHMARK_TEMPLATE(BM_RationalGemm, 64)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_RationalGemm, 128)->Unit(benchmark::kMillisecond);
+
+template <unsigned Size>
+void BM_BigIntegerMultiply(benchmark::State& state) {
+    Matrix<Size, Size, BigInteger> matrix1(random_table(Size, Size, 1000, 1));
+    Matrix<Size, Size, BigInteger> matrix2(random_table(Size, Size, 1000, 2));
+    for (auto _ : state)
+        benchmark::DoNotOptimize((matrix1 * matrix2)[0]);
+}
+BENCHMARK_TEMPLATE(BM_BigIntegerMultiply, 128)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_BigIntegerMultiply, 256)->Unit(benchmark::kMillisecond);
+
+
+/////////////    FINITE    /////////////
+vector<Field> random_elements(size_t count, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    vector<Field> elements(count);
+    for (Field& el : elements)
+        el = static_cast<int>(rng() % (prime - 1) + 1);
+    return elements;
+}
+
+void BM_FiniteInverse(benchmark::State& state) {
+    vector<Field> elements = random_elements(1024, 1);
+    for (auto _ : state)
+        for (const Field& el : elements)
+            benchmark::DoNotOptimize(el.get_opposite());
+    state.SetItemsProcessed(state.iterations() * elements.size());
+}
+BENCHMARK(BM_FiniteInverse);
+
+void BM_FiniteInvertBatch(benchmark::State& state) {
+    vector<Field> elements = random_elements(1024, 1);
+    for (auto _ : state) {
+        invert_batch(elements.data(), elements.size());
+        benchmark::DoNotOptimize(elements.data());
+    }
+    state.SetItemsProcessed(state.iterations() * elements.size());
+}
+BENCHMARK(BM_FiniteInvertBatch);
+
+// строка матрицы 512 x 512: y += a * x
+void BM_FiniteAxpy(benchmark::State& state) {
+    vector<Field> x = random_elements(512, 1), y = random_elements(512, 2);
+    Field a = 12345;
+    for (auto _ : state) {
+        axpy_batch(y.data(), x.data(), a, y.size());
+        benchmark::DoNotOptimize(y.data());
+    }
+    state.SetItemsProcessed(state.iterations() * y.size());
+}
+BENCHMARK(BM_FiniteAxpy);
+
+template <unsigned Size>
+void BM_FiniteDet(benchmark::State& state) {
+    Matrix<Size, Size, Field> matrix(random_table(Size, Size, prime, 1));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(matrix.det());
+    state.SetComplexityN(Size);
+}
+BENCHMARK_TEMPLATE(BM_FiniteDet, 32)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_FiniteDet, 64)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_FiniteDet, 128)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_FiniteDet, 256)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_FiniteDet, 512)->Unit(benchmark::kMillisecond);
+
+template <unsigned Size>
+void BM_FiniteRank(benchmark::State& state) {
+    Matrix<Size, Size, Field> matrix(random_table(Size, Size, prime, 1));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(matrix.rank());
+}
+BENCHMARK_TEMPLATE(BM_FiniteRank, 64)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_FiniteRank, 256)->Unit(benchmark::kMillisecond);
+
+template <unsigned Size>
+void BM_FiniteInvert(benchmark::State& state) {
+    Matrix<Size, Size, Field> matrix(random_table(Size, Size, prime, 1));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(matrix.inverted());
+}
+BENCHMARK_TEMPLATE(BM_FiniteInvert, 64)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_FiniteInvert, 256)->Unit(benchmark::kMillisecond);
+
+template <unsigned Size>
+void BM_FiniteMultiply(benchmark::State& state) {
+    Matrix<Size, Size, Field> matrix1(random_table(Size, Size, prime, 1));
+    Matrix<Size, Size, Field> matrix2(random_table(Size, Size, prime, 2));
+    for (auto _ : state)
+        benchmark::DoNotOptimize((matrix1 * matrix2)[0]);
+    state.SetItemsProcessed(state.iterations() * Size * Size * Size);
+}
+BENCHMARK_TEMPLATE(BM_FiniteMultiply, 64)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_FiniteMultiply, 256)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_FiniteMultiply, 1024)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_FiniteMultiply, 2048)->Unit(benchmark::kMillisecond);
+
+
+/////////////    DYN FINITE    /////////////
+// тот же модуль, но заданный во время выполнения; сравнивать с BM_Finite*
+const FiniteModulus runtime_prime(prime);
+
+template <unsigned Size>
+void BM_DynFiniteDet(benchmark::State& state) {
+    DynFinite::Scope scope(runtime_prime);
+    Matrix<Size, Size, DynFinite> matrix(random_table(Size, Size, prime, 1));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(matrix.det());
+}
+BENCHMARK_TEMPLATE(BM_DynFiniteDet, 64)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_DynFiniteDet, 256)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_DynFiniteDet, 512)->Unit(benchmark::kMillisecond);
+
+template <unsigned Size>
+void BM_DynFiniteInvert(benchmark::State& state) {
+    DynFinite::Scope scope(runtime_prime);
+    Matrix<Size, Size, DynFinite> matrix(random_table(Size, Size, prime, 1));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(matrix.inverted());
+}
+BENCHMARK_TEMPLATE(BM_DynFiniteInvert, 64)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_DynFiniteInvert, 256)->Unit(benchmark::kMillisecond);
+
+template <unsigned Size>
+void BM_DynFiniteMultiply(benchmark::State& state) {
+    DynFinite::Scope scope(runtime_prime);
+    Matrix<Size, Size, DynFinite> matrix1(random_table(Size, Size, prime, 1));
+    Matrix<Size, Size, DynFinite> matrix2(random_table(Size, Size, prime, 2));
+    for (auto _ : state)
+        benchmark::DoNotOptimize((matrix1 * matrix2)[0]);
+    state.SetItemsProcessed(state.iterations() * Size * Size * Size);
+}
+BENCHMARK_TEMPLATE(BM_DynFiniteMultiply, 256)->Unit(benchmark::kMillisecond);
+
+
+
+/////////////    POWER    /////////////
+// член номер 10^18 рекуррентности порядка Order по модулю prime
+const uint64_t huge_exponent = 1000000000000000000;
+
+template <unsigned Order>
+Matrix<Order, Order, Field> companion_matrix() {
+    Matrix<Order, Order, Field> matrix;
+    vector<vector<int>> coefficients = random_table(1, Order, prime, 1);
+    for (size_t j = 0; j < Order; ++j)
+        matrix[0][j] = Field(coefficients[0][j]);
+    for (size_t i = 1; i < Order; ++i) {
+        matrix[i][i] = Field(0);
+        matrix[i][i - 1] = Field(1);
+    }
+    return matrix;
+}
+
+// pow узнаёт матрицу-компаньон и считает x^N по модулю её многочлена
+template <unsigned Order>
+void BM_RecurrencePow(benchmark::State& state) {
+    Matrix<Order, Order, Field> matrix = companion_matrix<Order>();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(matrix.pow(huge_exponent)[0]);
+}
+BENCHMARK_TEMPLATE(BM_RecurrencePow, 2);
+BENCHMARK_TEMPLATE(BM_RecurrencePow, 16);
+BENCHMARK_TEMPLATE(BM_RecurrencePow, 64)->Unit(benchmark::kMillisecond);
+
+// прежний способ: двоичное возведение на operator*= и operator*, power — единичная
+template <unsigned Order>
+void BM_RecurrenceMultiply(benchmark::State& state) {
+    Matrix<Order, Order, Field> matrix = companion_matrix<Order>();
+    for (auto _ : state) {
+        Matrix<Order, Order, Field> power, base = matrix;
+        for (uint64_t exponent = huge_exponent; exponent; exponent >>= 1) {
+            if (exponent & 1)
+                power = power * base;
+            base *= base;
+        }
+        benchmark::DoNotOptimize(power[0]);
+    }
+}
+BENCHMARK_TEMPLATE(BM_RecurrenceMultiply, 2);
+BENCHMARK_TEMPLATE(BM_RecurrenceMultiply, 16);
+BENCHMARK_TEMPLATE(BM_RecurrenceMultiply, 64)->Unit(benchmark::kMillisecond);
+
+// плотная матрица: квадраты и умножения в двух сменяющихся буферах
+template <unsigned Size>
+void BM_DensePow(benchmark::State& state) {
+    Matrix<Size, Size, Field> matrix(random_table(Size, Size, prime, 1));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(matrix.pow(huge_exponent)[0]);
+}
+BENCHMARK_TEMPLATE(BM_DensePow, 16);
+BENCHMARK_TEMPLATE(BM_DensePow, 256)->Unit(benchmark::kMillisecond);
+
+/////////////    INTEGER    /////////////
+// целочисленные матрицы с элементами до 1000 по модулю
+template <unsigned Size>
+Matrix<Size, Size> integer_matrix() {
+    vector<vector<int>> table = random_table(Size, Size, 2001, 1);
+    for (vector<int>& row : table)
+        for (int& el : row)
+            el -= 1000;
+    return Matrix<Size, Size>(table);
+}
+
+// det() целочисленной Rational-матрицы: остатки по простым и китайская теорема
+template <unsigned Size>
+void BM_IntegerDet(benchmark::State& state) {
+    Matrix<Size, Size> matrix = integer_matrix<Size>();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(matrix.det());
+}
+BENCHMARK_TEMPLATE(BM_IntegerDet, 16)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_IntegerDet, 32)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_IntegerDet, 100)->Unit(benchmark::kMillisecond);
+
+template <unsigned Size>
+void BM_BareissDet(benchmark::State& state) {
+    Matrix<Size, Size> matrix = integer_matrix<Size>();
+    vector<BigInteger> table;
+    for (size_t i = 0; i < size_t(Size) * Size; ++i)
+        table.push_back(matrix[0][i].getNumerator());
+    for (auto _ : state)
+        benchmark::DoNotOptimize(bareiss_det(table, Size, Execution::sequential()));
+}
+BENCHMARK_TEMPLATE(BM_BareissDet, 16)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_BareissDet, 32)->Unit(benchmark::kMillisecond);
+
+// прежний путь: Гаусс над Rational с сокращением дробей на каждом шаге
+template <unsigned Size>
+void BM_GaussRationalDet(benchmark::State& state) {
+    Matrix<Size, Size> matrix = integer_matrix<Size>();
+    for (auto _ : state) {
+        Matrix<Size, Size> copy = matrix;
+        benchmark::DoNotOptimize(det_table(copy[0], Size, Execution::sequential()));
+    }
+}
+BENCHMARK_TEMPLATE(BM_GaussRationalDet, 16)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_GaussRationalDet, 32)->Unit(benchmark::kMillisecond);
+
+// ранг по простым модулям: невырожденной матрице хватает одного простого
+template <unsigned Size>
+void BM_IntegerRank(benchmark::State& state) {
+    Matrix<Size, Size> matrix = integer_matrix<Size>();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(matrix.rank());
+}
+BENCHMARK_TEMPLATE(BM_IntegerRank, 32)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_IntegerRank, 100)->Unit(benchmark::kMillisecond);
+
+
+/////////////    PARALLEL    /////////////
+// масштабирование по числу потоков: аргумент — threads для Execution::parallel,
+// 1 — тот же код без пула
+void thread_counts(benchmark::internal::Benchmark* bench) {
+    bench->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime()->Unit(benchmark::kMillisecond);
+}
+
+template <unsigned Size>
+void BM_ParallelMultiply(benchmark::State& state) {
+    Matrix<Size, Size, double> matrix1(random_table(Size, Size, 1000, 1));
+    Matrix<Size, Size, double> matrix2(random_table(Size, Size, 1000, 2));
+    Execution policy = Execution::parallel(state.range(0));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(multiply(matrix1, matrix2, policy)[0]);
+    state.counters["flops"] = benchmark::Counter(2.0 * Size * Size * Size, benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK_TEMPLATE(BM_ParallelMultiply, 1024)->Apply(thread_counts);
+
+template <unsigned Size>
+void BM_ParallelFiniteDet(benchmark::State& state) {
+    Matrix<Size, Size, Field> matrix(random_table(Size, Size, prime, 1));
+    Execution policy = Execution::parallel(state.range(0));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(matrix.det(policy));
+}
+BENCHMARK_TEMPLATE(BM_ParallelFiniteDet, 512)->Apply(thread_counts);
+
+template <unsigned Size>
+void BM_ParallelDynFiniteInvert(benchmark::State& state) {
+    DynFinite::Scope scope(runtime_prime);
+    Matrix<Size, Size, DynFinite> matrix(random_table(Size, Size, prime, 1));
+    Execution policy = Execution::parallel(state.range(0));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(matrix.inverted(policy));
+}
+BENCHMARK_TEMPLATE(BM_ParallelDynFiniteInvert, 256)->Apply(thread_counts);
+
+// строка Rational — сотни сокращений дробей, так что делить есть что и при 64 x 64;
+// знаменатель 7 уводит матрицу с целочисленного пути на обычного Гаусса
+template <unsigned Size>
+void BM_ParallelRationalDet(benchmark::State& state) {
+    Matrix<Size, Size> matrix(random_table(Size, Size, 100, 1));
+    matrix *= Rational(1, 7);
+    Execution policy = Execution::parallel(state.range(0));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(matrix.det(policy));
+}
+BENCHMARK_TEMPLATE(BM_ParallelRationalDet, 32)->Apply(thread_counts);
+
+template <unsigned Size>
+void BM_ParallelRationalMultiply(benchmark::State& state) {
+    Matrix<Size, Size> matrix1(random_table(Size, Size, 1000, 1));
+    Matrix<Size, Size> matrix2(random_table(Size, Size, 1000, 2));
+    Execution policy = Execution::parallel(state.range(0));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(multiply(matrix1, matrix2, policy)[0]);
+}
+BENCHMARK_TEMPLATE(BM_ParallelRationalMultiply, 64)->Apply(thread_counts);
+
+} // namespace
+
+BENCHMARK_MAIN();
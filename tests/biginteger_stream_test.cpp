@@ -0,0 +1,76 @@
+#include "biginteger.h"
+
+#include <cstdio>
+
+// Чтение через streambuf без окна [gptr, egptr): так ведёт себя std::cin при
+// sync_with_stdio(true) — символы отдаются только через underflow/uflow
+namespace {
+
+class UnbufferedBuf : public std::streambuf {
+private:
+    string data;
+    size_t pos = 0;
+protected:
+    int_type underflow() override {
+        return pos < data.size() ? traits_type::to_int_type(data[pos]) : traits_type::eof();
+    }
+    int_type uflow() override {
+        return pos < data.size() ? traits_type::to_int_type(data[pos++]) : traits_type::eof();
+    }
+public:
+    explicit UnbufferedBuf(string data): data(std::move(data)) {}
+};
+
+int failures = 0;
+
+void check(bool condition, const char* what) {
+    if (!condition) {
+        std::fprintf(stderr, "FAILED: %s\n", what);
+        ++failures;
+    }
+}
+
+}
+
+int main() {
+    string long_number = "-" + string(100, '9') + "12345678901234567890";
+    UnbufferedBuf buffer("12345 " + long_number + " 7/21 -12.375 +42x");
+    istream in(&buffer);
+
+    BigInteger a, b;
+    in >> a >> b;
+    check(in && a == 12345, "short number");
+    check(in && b.toString() == long_number, "long number");
+
+    Rational p, q;
+    in >> p >> q;
+    check(in && p == Rational(1, 3), "fraction p/q");
+    check(in && q == Rational(BigInteger(-99), BigInteger(8)), "decimal fraction");
+
+    BigInteger c;
+    in >> c;
+    check(in && c == 42 && buffer.sgetc() == 'x', "stops at a non-digit");
+    in >> c;
+    check(!in, "non-digit is an error");
+
+    // знак без цифр: буферизованный поток получает его назад, небуферизованный — нет
+    std::istringstream signed_in("-x +");
+    signed_in >> c;
+    check(!signed_in && signed_in.rdbuf()->sgetc() == '-', "sign without digits is put back");
+    signed_in.clear();
+    signed_in.ignore(2);
+    signed_in >> p;
+    check(!signed_in && signed_in.rdbuf()->sgetc() == '+', "sign at the end is put back");
+
+    UnbufferedBuf unbuffered_sign("-x");
+    istream in3(&unbuffered_sign);
+    in3 >> c;
+    check(!in3 && unbuffered_sign.sgetc() == 'x', "unbuffered sign without digits is consumed");
+
+    UnbufferedBuf empty("");
+    istream in2(&empty);
+    in2 >> c;
+    check(!in2, "empty input");
+
+    return failures == 0 ? 0 : 1;
+}